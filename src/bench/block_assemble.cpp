@@ -67,6 +67,7 @@ static void AssembleBlock(benchmark::State& state)
     SelectParams(TAPYRUS_OP_MODE::DEV);
 
     InitScriptExecutionCache();
+    InitBlockProofCache();
 
     boost::thread_group thread_group;
     CScheduler scheduler;
@@ -0,0 +1,63 @@
+// Copyright (c) 2019 Chaintope Inc.
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+#include <chain.h>
+#include <clientversion.h>
+#include <random.h>
+#include <streams.h>
+
+#include <vector>
+
+static const int BLOCK_INDEX_ENTRIES = 10000;
+
+// Rebuild a chain of block index entries from their database records, the way
+// LoadBlockIndexGuts does at startup.
+static void BlockIndexLoad(benchmark::State& state)
+{
+    FastRandomContext rand(true);
+    CDataStream records(SER_DISK, CLIENT_VERSION);
+    uint256 hashPrev;
+    for (int i = 0; i < BLOCK_INDEX_ENTRIES; i++) {
+        CBlockHeader header;
+        header.nFeatures = CBlockHeader::TAPYRUS_BLOCK_FEATURES;
+        header.hashPrevBlock = hashPrev;
+        header.hashMerkleRoot = rand.rand256();
+        header.hashImMerkleRoot = rand.rand256();
+        header.nTime = i;
+        header.proof = rand.randbytes(64);
+        CBlockIndex index(header);
+        index.nHeight = i;
+        index.nStatus = BLOCK_VALID_SCRIPTS | BLOCK_HAVE_DATA | BLOCK_HAVE_UNDO;
+        CDiskBlockIndex diskindex(&index);
+        diskindex.hashPrev = hashPrev;
+        records << diskindex;
+        hashPrev = diskindex.GetBlockHash();
+    }
+
+    CBlockIndexArena arena;
+    while (state.KeepRunning()) {
+        CDataStream stream(records);
+        CBlockIndex* pprev = nullptr;
+        for (int i = 0; i < BLOCK_INDEX_ENTRIES; i++) {
+            CDiskBlockIndex diskindex;
+            stream >> diskindex;
+            CBlockIndex* pindexNew = arena.Create();
+            pindexNew->pprev = pprev;
+            pindexNew->nHeight = diskindex.nHeight;
+            pindexNew->nStatus = diskindex.nStatus;
+            pindexNew->nFeatures = diskindex.nFeatures;
+            pindexNew->hashMerkleRoot = diskindex.hashMerkleRoot;
+            pindexNew->hashImMerkleRoot = diskindex.hashImMerkleRoot;
+            pindexNew->nTime = diskindex.nTime;
+            pindexNew->xfieldType = diskindex.xfieldType;
+            pindexNew->CopyXFieldAndProof(diskindex);
+            pindexNew->BuildSkip();
+            pprev = pindexNew;
+        }
+        arena.Clear();
+    }
+}
+
+BENCHMARK(BlockIndexLoad, 50);
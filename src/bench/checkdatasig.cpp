@@ -0,0 +1,115 @@
+// Copyright (c) 2019 Chaintope Inc.
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+#include <crypto/common.h>
+#include <crypto/sha256.h>
+#include <key.h>
+#include <policy/policy.h>
+#include <primitives/transaction.h>
+#include <pubkey.h>
+#include <script/interpreter.h>
+#include <script/sigcache.h>
+#include <script/standard.h>
+
+#include <vector>
+
+// Oracle settlement: every contract on an event is settled by a spend that
+// proves the outcome the oracle signed with OP_CHECKDATASIGVERIFY and then pays
+// out to a P2PKH key. Each iteration settles a fresh event, checking every
+// spend twice, as mempool acceptance and then block connection do.
+static const int SETTLEMENTS_PER_EVENT = 16;
+
+struct OracleEvent {
+    CMutableTransaction txCredit;
+    std::vector<CTransactionRef> vtx;
+    std::vector<PrecomputedTransactionData> txdata;
+};
+
+static std::vector<OracleEvent> CreateOracleEvents(size_t nEvents)
+{
+    CKey oracleKey, payeeKey;
+    oracleKey.MakeNewKey(true);
+    payeeKey.MakeNewKey(true);
+    const CPubKey payeePubKey = payeeKey.GetPubKey();
+    const CScript scriptPubKey = CScript() << ToByteVector(oracleKey.GetPubKey()) << OP_CHECKDATASIGVERIFY << OP_DUP << OP_HASH160 << ToByteVector(payeePubKey.GetID()) << OP_EQUALVERIFY << OP_CHECKSIG;
+
+    std::vector<OracleEvent> vEvents(nEvents);
+    for (size_t e = 0; e < nEvents; e++) {
+        OracleEvent& event = vEvents[e];
+
+        // The attested outcome: event number and result
+        std::vector<unsigned char> message(16);
+        WriteLE64(message.data(), e);
+        WriteLE64(message.data() + 8, 1);
+        uint256 messageHash;
+        CSHA256().Write(message.data(), message.size()).Finalize(messageHash.begin());
+        std::vector<unsigned char> vchDataSig;
+        bool ret = oracleKey.Sign_Schnorr(messageHash, vchDataSig);
+        assert(ret);
+
+        event.txCredit.nFeatures = 1;
+        event.txCredit.nLockTime = e;
+        event.txCredit.vin.resize(1);
+        event.txCredit.vout.resize(SETTLEMENTS_PER_EVENT, CTxOut(1000, scriptPubKey));
+        for (int i = 0; i < SETTLEMENTS_PER_EVENT; i++) {
+            CMutableTransaction mtx;
+            mtx.nFeatures = 1;
+            mtx.vin.emplace_back(COutPoint(event.txCredit.GetHashMalFix(), i));
+            mtx.vout.emplace_back(900, GetScriptForDestination(payeePubKey.GetID()));
+            std::vector<unsigned char> vchSig;
+            ret = payeeKey.Sign_Schnorr(SignatureHash(scriptPubKey, mtx, 0, SIGHASH_ALL, 1000, SigVersion::BASE), vchSig);
+            assert(ret);
+            vchSig.push_back(static_cast<unsigned char>(SIGHASH_ALL));
+            mtx.vin[0].scriptSig = CScript() << vchSig << ToByteVector(payeePubKey) << vchDataSig << message;
+            event.vtx.push_back(MakeTransactionRef(std::move(mtx)));
+            event.txdata.emplace_back(*event.vtx.back());
+        }
+    }
+    return vEvents;
+}
+
+static void VerifySettlement(const OracleEvent& event, int i, const BaseSignatureChecker& checker)
+{
+    const CTransaction& tx = *event.vtx[i];
+    ColorIdentifier colorId;
+    bool ret = VerifyScript(tx.vin[0].scriptSig, event.txCredit.vout[i].scriptPubKey, nullptr, STANDARD_SCRIPT_VERIFY_FLAGS, checker, colorId);
+    assert(ret);
+}
+
+static void OracleSettlementUncached(benchmark::State& state)
+{
+    ECCVerifyHandle verify_handle;
+    std::vector<OracleEvent> vEvents = CreateOracleEvents(state.m_num_evals * state.m_num_iters);
+
+    size_t e = 0;
+    while (state.KeepRunning()) {
+        const OracleEvent& event = vEvents[e++];
+        for (int pass = 0; pass < 2; pass++) {
+            for (int i = 0; i < SETTLEMENTS_PER_EVENT; i++) {
+                VerifySettlement(event, i, TransactionSignatureChecker(event.vtx[i].get(), 0, 1000, event.txdata[i]));
+            }
+        }
+    }
+}
+
+static void OracleSettlementCached(benchmark::State& state)
+{
+    ECCVerifyHandle verify_handle;
+    InitSignatureCache();
+    std::vector<OracleEvent> vEvents = CreateOracleEvents(state.m_num_evals * state.m_num_iters);
+
+    size_t e = 0;
+    while (state.KeepRunning()) {
+        OracleEvent& event = vEvents[e++];
+        for (bool store : {true, false}) {
+            for (int i = 0; i < SETTLEMENTS_PER_EVENT; i++) {
+                VerifySettlement(event, i, CachingTransactionSignatureChecker(event.vtx[i].get(), 0, 1000, store, event.txdata[i]));
+            }
+        }
+    }
+}
+
+BENCHMARK(OracleSettlementUncached, 1);
+BENCHMARK(OracleSettlementCached, 1);
@@ -0,0 +1,66 @@
+// Copyright (c) 2019 Chaintope Inc.
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+#include <checkqueue.h>
+#include <key.h>
+#include <primitives/block.h>
+#include <pubkey.h>
+#include <util.h>
+#include <validation.h>
+
+#include <boost/thread/thread.hpp>
+
+#include <vector>
+
+// One full headers message worth of signed headers.
+static const size_t HEADERS = MAX_HEADERS_RESULTS;
+
+static void CheckBlockHeadersThreads(benchmark::State& state, int nThreads)
+{
+    ECCVerifyHandle verify_handle;
+    // Shrink the block proof cache to its minimum so that every iteration
+    // measures the verification rather than cache lookups.
+    gArgs.ForceSetArg("-maxblockproofcachesize", "0");
+    InitBlockProofCache();
+
+    CKey key;
+    key.MakeNewKey(true);
+    const CPubKey pubkey = key.GetPubKey();
+
+    std::vector<CBlockHeader> headers(HEADERS);
+    uint256 prev;
+    for (size_t i = 0; i < headers.size(); i++) {
+        CBlockHeader& header = headers[i];
+        header.nFeatures = CBlockHeader::TAPYRUS_BLOCK_FEATURES;
+        header.hashPrevBlock = prev;
+        header.nTime = 1562500000 + i;
+        bool ret = key.Sign_Schnorr(header.GetHashForSign(), header.proof);
+        assert(ret);
+        prev = header.GetHash();
+    }
+
+    // The master thread joins the pool while waiting, so start one less.
+    CCheckQueue<CBlockHeaderCheck> queue(1);
+    boost::thread_group tg;
+    for (int i = 0; i < nThreads - 1; i++) {
+        tg.create_thread([&]{queue.Thread();});
+    }
+
+    std::vector<unsigned char> vValid;
+    while (state.KeepRunning()) {
+        CheckBlockHeaders(headers, pubkey, vValid, &queue);
+        assert(vValid.back() == 1);
+    }
+    tg.interrupt_all();
+    tg.join_all();
+}
+
+static void CheckBlockHeaders1Thread(benchmark::State& state) { CheckBlockHeadersThreads(state, 1); }
+static void CheckBlockHeaders4Threads(benchmark::State& state) { CheckBlockHeadersThreads(state, 4); }
+static void CheckBlockHeaders16Threads(benchmark::State& state) { CheckBlockHeadersThreads(state, 16); }
+
+BENCHMARK(CheckBlockHeaders1Thread, 5);
+BENCHMARK(CheckBlockHeaders4Threads, 10);
+BENCHMARK(CheckBlockHeaders16Threads, 20);
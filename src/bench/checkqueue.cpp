@@ -10,6 +10,7 @@
 #include <vector>
 #include <boost/thread/thread.hpp>
 #include <random.h>
+#include <crypto/sha256.h>
 
 
 static const int MIN_CORES = 2;
@@ -60,3 +61,53 @@ static void CCheckQueueSpeedPrevectorJob(benchmark::State& state)
     tg.join_all();
 }
 BENCHMARK(CCheckQueueSpeedPrevectorJob, 1400);
+
+// Scaling curve of the CheckQueue with many cheap checks, which is the shape
+// of a block full of token transfers: each check hashes a few bytes only.
+static const size_t CHEAP_CHECKS = 20000;
+
+static void CCheckQueueCheapJobsThreads(benchmark::State& state, int nThreads)
+{
+    struct CheapJob {
+        unsigned char data[32] = {0};
+        bool operator()()
+        {
+            CSHA256().Write(data, sizeof(data)).Finalize(data);
+            return true;
+        }
+        void swap(CheapJob& x) { std::swap(data, x.data); }
+    };
+    CCheckQueue<CheapJob> queue {QUEUE_BATCH_SIZE};
+    // The master thread joins the pool while waiting, so start one less.
+    boost::thread_group tg;
+    for (int i = 0; i < nThreads - 1; i++) {
+       tg.create_thread([&]{queue.Thread();});
+    }
+    while (state.KeepRunning()) {
+        CCheckQueueControl<CheapJob> control(&queue);
+        // Add in small batches, the way ConnectBlock adds the inputs of each transaction.
+        for (size_t i = 0; i < CHEAP_CHECKS; i += 2) {
+            std::vector<CheapJob> vChecks(2);
+            control.Add(vChecks);
+        }
+        control.Wait();
+    }
+    tg.interrupt_all();
+    tg.join_all();
+}
+
+static void CCheckQueueCheapJobs1Thread(benchmark::State& state) { CCheckQueueCheapJobsThreads(state, 1); }
+static void CCheckQueueCheapJobs2Threads(benchmark::State& state) { CCheckQueueCheapJobsThreads(state, 2); }
+static void CCheckQueueCheapJobs4Threads(benchmark::State& state) { CCheckQueueCheapJobsThreads(state, 4); }
+static void CCheckQueueCheapJobs8Threads(benchmark::State& state) { CCheckQueueCheapJobsThreads(state, 8); }
+static void CCheckQueueCheapJobs16Threads(benchmark::State& state) { CCheckQueueCheapJobsThreads(state, 16); }
+static void CCheckQueueCheapJobs32Threads(benchmark::State& state) { CCheckQueueCheapJobsThreads(state, 32); }
+static void CCheckQueueCheapJobs64Threads(benchmark::State& state) { CCheckQueueCheapJobsThreads(state, 64); }
+
+BENCHMARK(CCheckQueueCheapJobs1Thread, 10);
+BENCHMARK(CCheckQueueCheapJobs2Threads, 10);
+BENCHMARK(CCheckQueueCheapJobs4Threads, 10);
+BENCHMARK(CCheckQueueCheapJobs8Threads, 10);
+BENCHMARK(CCheckQueueCheapJobs16Threads, 10);
+BENCHMARK(CCheckQueueCheapJobs32Threads, 10);
+BENCHMARK(CCheckQueueCheapJobs64Threads, 10);
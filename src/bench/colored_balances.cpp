@@ -0,0 +1,78 @@
+// Copyright (c) 2020 Chaintope Inc.
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+
+#include <primitives/transaction.h>
+#include <script/script.h>
+#include <coloridentifier.h>
+
+#include <map>
+
+// The seven balance caches of a CWalletTx, debit and credit seeded with TPC
+// as in CWalletTx::Init.
+template <typename Map>
+struct WalletTxBalanceCaches {
+    Map nDebitCached;
+    Map nCreditCached;
+    Map nAvailableCreditCached;
+    Map nWatchDebitCached;
+    Map nWatchCreditCached;
+    Map nAvailableWatchCreditCached;
+    Map nChangeCached;
+
+    WalletTxBalanceCaches() {
+        nDebitCached[ColorIdentifier()] = 0;
+        nCreditCached[ColorIdentifier()] = 0;
+    }
+};
+
+// Load a 100k transaction wallet and compute its balance once.
+template <typename Map>
+static void ColoredBalancesWallet(benchmark::State& state)
+{
+    const ColorIdentifier tpc;
+    while (state.KeepRunning()) {
+        std::vector<WalletTxBalanceCaches<Map>> vwtx(100000);
+        CAmount nTotal = 0;
+        for (auto& wtx : vwtx) {
+            wtx.nCreditCached[tpc] = 10;
+            wtx.nAvailableCreditCached[tpc] = 10;
+            wtx.nChangeCached[tpc] = 0;
+            nTotal += wtx.nAvailableCreditCached[tpc] + wtx.nCreditCached[tpc] - wtx.nDebitCached[tpc];
+        }
+        assert(nTotal == 2000000);
+    }
+}
+
+// Sum the input and output balances of a transaction moving TPC and one token.
+template <typename Map>
+static void ColoredBalancesTx(benchmark::State& state)
+{
+    const ColorIdentifier tpc;
+    const ColorIdentifier token(CScript() << OP_TRUE);
+    while (state.KeepRunning()) {
+        for (int i = 0; i < 1000; i++) {
+            Map in, out;
+            for (int j = 0; j < 4; j++) {
+                in[j & 1 ? token : tpc] += 10;
+                out[j & 1 ? token : tpc] += 9;
+            }
+            for (const auto& entry : out) {
+                assert(in.find(entry.first)->second >= entry.second);
+            }
+        }
+    }
+}
+
+static void ColoredBalancesWalletStdMap(benchmark::State& state) { ColoredBalancesWallet<std::map<ColorIdentifier, CAmount, ColorIdentifierCompare>>(state); }
+// as CachedColoredCoinBalancesMap in wallet/wallet.h
+static void ColoredBalancesWalletSmallMap(benchmark::State& state) { ColoredBalancesWallet<smallmap<1, ColorIdentifier, CAmount, ColorIdentifierCompare>>(state); }
+static void ColoredBalancesTxStdMap(benchmark::State& state) { ColoredBalancesTx<std::map<ColorIdentifier, CAmount, ColorIdentifierCompare>>(state); }
+static void ColoredBalancesTxSmallMap(benchmark::State& state) { ColoredBalancesTx<TxColoredCoinBalancesMap>(state); }
+
+BENCHMARK(ColoredBalancesWalletStdMap, 2);
+BENCHMARK(ColoredBalancesWalletSmallMap, 2);
+BENCHMARK(ColoredBalancesTxStdMap, 100);
+BENCHMARK(ColoredBalancesTxSmallMap, 100);
@@ -0,0 +1,41 @@
+// Copyright (c) 2020 Chaintope Inc.
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+
+#include <coins.h>
+#include <coloridentifier.h>
+#include <consensus/validation.h>
+#include <random.h>
+#include <script/script.h>
+#include <validation.h>
+
+// A 500 input, 500 output token issue: output i issues a non-reissuable
+// token out of input i, so matching an output against the inputs one by one
+// costs a hash per input tried.
+static void CheckColorIdentifierValidity500(benchmark::State& state)
+{
+    FastRandomContext rand(true);
+    CCoinsView viewDummy;
+    CCoinsViewCache view(&viewDummy);
+    const CScript scriptPubKey = CScript() << OP_DUP << OP_HASH160 << rand.randbytes(20) << OP_EQUALVERIFY << OP_CHECKSIG;
+
+    CMutableTransaction mtx;
+    for (int i = 0; i < 500; i++) {
+        COutPoint prevout(rand.rand256(), i);
+        view.AddCoin(prevout, Coin(CTxOut(CENT, scriptPubKey), 1, false, TokenTypes::NONE), false);
+        mtx.vin.emplace_back(prevout);
+        const ColorIdentifier colorId(prevout, TokenTypes::NON_REISSUABLE);
+        mtx.vout.emplace_back(100, CScript() << colorId.toVector() << OP_COLOR << OP_DUP << OP_HASH160 << rand.randbytes(20) << OP_EQUALVERIFY << OP_CHECKSIG);
+    }
+    const CTransaction tx(mtx);
+
+    while (state.KeepRunning()) {
+        CValidationState validationState;
+        bool ret = CheckColorIdentifierValidity(tx, validationState, view);
+        assert(ret);
+    }
+}
+
+BENCHMARK(CheckColorIdentifierValidity500, 50);
@@ -0,0 +1,168 @@
+// Copyright (c) 2019 Chaintope Inc.
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+#include <chainparams.h>
+#include <checkqueue.h>
+#include <coins.h>
+#include <consensus/validation.h>
+#include <key.h>
+#include <policy/policy.h>
+#include <scheduler.h>
+#include <script/sigcache.h>
+#include <script/standard.h>
+#include <tapyrusmodes.h>
+#include <txmempool.h>
+#include <utiltime.h>
+#include <validation.h>
+#include <validationinterface.h>
+
+#include <boost/thread.hpp>
+
+#include <list>
+#include <vector>
+
+// A flood of independent single input Schnorr P2PKH spends, taken in as one
+// batch per iteration. Every iteration spends fresh coins so that the
+// signature cache only helps within the batch, as it would for new transactions.
+static const int FLOOD_TXS = 256;
+
+/**
+ * Just enough of a chain state for mempool acceptance: a tip with no parent
+ * and a coins cache holding the coins the flood spends.
+ */
+class MempoolAcceptBenchSetup
+{
+    ECCVerifyHandle verify_handle;
+    CCoinsView coinsdummy;
+    CBlockIndex tip;
+    boost::thread_group threadGroup;
+    CScheduler scheduler;
+
+public:
+    MempoolAcceptBenchSetup()
+    {
+        SelectParams(TAPYRUS_OP_MODE::DEV);
+        InitSignatureCache();
+        InitScriptExecutionCache();
+
+        threadGroup.create_thread(boost::bind(&CScheduler::serviceQueue, &scheduler));
+        GetMainSignals().RegisterBackgroundSignalScheduler(scheduler);
+
+        LOCK(cs_main);
+        CBlockHeader header;
+        header.nTime = GetTime();
+        tip = CBlockIndex(header);
+        tip.phashBlock = &mapBlockIndex.emplace(header.GetHash(), &tip).first->first;
+        chainActive.SetTip(&tip);
+        pindexBestHeader = &tip;
+        pcoinsTip.reset(new CCoinsViewCache(&coinsdummy));
+        pcoinsTip->SetBestBlock(tip.GetBlockHash());
+    }
+
+    ~MempoolAcceptBenchSetup()
+    {
+        {
+            LOCK(cs_main);
+            mempool.clear();
+            chainActive.SetTip(nullptr);
+            pindexBestHeader = nullptr;
+            mapBlockIndex.erase(tip.GetBlockHash());
+            pcoinsTip.reset();
+        }
+        threadGroup.interrupt_all();
+        threadGroup.join_all();
+        GetMainSignals().FlushBackgroundCallbacks();
+        GetMainSignals().UnregisterBackgroundSignalScheduler();
+    }
+};
+
+static std::vector<std::vector<CTransactionRef>> CreateFloods(size_t nFloods)
+{
+    CKey key;
+    key.MakeNewKey(true);
+    const CPubKey pubkey = key.GetPubKey();
+    const CScript scriptPubKey = GetScriptForDestination(pubkey.GetID());
+
+    std::vector<std::vector<CTransactionRef>> vFloods(nFloods);
+    LOCK(cs_main);
+    for (size_t f = 0; f < nFloods; f++) {
+        CMutableTransaction txCredit;
+        txCredit.nFeatures = 1;
+        txCredit.nLockTime = f;
+        txCredit.vin.resize(1);
+        txCredit.vout.resize(FLOOD_TXS, CTxOut(COIN, scriptPubKey));
+        for (int i = 0; i < FLOOD_TXS; i++) {
+            pcoinsTip->AddCoin(COutPoint(txCredit.GetHashMalFix(), i), Coin(txCredit.vout[i], 0, false, TokenTypes::NONE), false);
+
+            CMutableTransaction mtx;
+            mtx.nFeatures = 1;
+            mtx.vin.emplace_back(COutPoint(txCredit.GetHashMalFix(), i));
+            mtx.vout.emplace_back(COIN - CENT, scriptPubKey);
+            std::vector<unsigned char> vchSig;
+            bool ret = key.Sign_Schnorr(SignatureHash(scriptPubKey, mtx, 0, SIGHASH_ALL, COIN, SigVersion::BASE), vchSig);
+            assert(ret);
+            vchSig.push_back(static_cast<unsigned char>(SIGHASH_ALL));
+            mtx.vin[0].scriptSig = CScript() << vchSig << ToByteVector(pubkey);
+            vFloods[f].push_back(MakeTransactionRef(std::move(mtx)));
+        }
+    }
+    return vFloods;
+}
+
+static void MempoolAcceptSerial(benchmark::State& state)
+{
+    MempoolAcceptBenchSetup setup;
+    std::vector<std::vector<CTransactionRef>> vFloods = CreateFloods(state.m_num_evals * state.m_num_iters);
+
+    size_t f = 0;
+    while (state.KeepRunning()) {
+        LOCK(cs_main);
+        for (const CTransactionRef& tx : vFloods[f]) {
+            CValidationState vstate;
+            bool ret = AcceptToMemoryPool(mempool, vstate, tx, nullptr, nullptr, false, 0);
+            assert(ret);
+        }
+        mempool.clear();
+        f++;
+    }
+}
+
+static void MempoolAcceptBatch(benchmark::State& state, int nThreads)
+{
+    MempoolAcceptBenchSetup setup;
+    std::vector<std::vector<CTransactionRef>> vFloods = CreateFloods(state.m_num_evals * state.m_num_iters);
+
+    CCheckQueue<CMempoolInputsCheck> queue(1);
+    boost::thread_group tg;
+    for (int i = 0; i < nThreads - 1; i++) {
+        tg.create_thread([&]{queue.Thread();});
+    }
+
+    size_t f = 0;
+    while (state.KeepRunning()) {
+        std::vector<CValidationState> vState;
+        std::vector<bool> vAccepted, vMissingInputs;
+        AcceptToMemoryPoolBatch(mempool, vFloods[f], vState, vAccepted, vMissingInputs, nullptr, 0, nThreads > 1 ? &queue : nullptr);
+        assert(std::find(vAccepted.begin(), vAccepted.end(), false) == vAccepted.end());
+        LOCK(cs_main);
+        mempool.clear();
+        f++;
+    }
+    tg.interrupt_all();
+    tg.join_all();
+}
+
+static void MempoolAcceptBatch1Thread(benchmark::State& state) { MempoolAcceptBatch(state, 1); }
+static void MempoolAcceptBatch2Threads(benchmark::State& state) { MempoolAcceptBatch(state, 2); }
+static void MempoolAcceptBatch4Threads(benchmark::State& state) { MempoolAcceptBatch(state, 4); }
+static void MempoolAcceptBatch8Threads(benchmark::State& state) { MempoolAcceptBatch(state, 8); }
+static void MempoolAcceptBatch16Threads(benchmark::State& state) { MempoolAcceptBatch(state, 16); }
+
+BENCHMARK(MempoolAcceptSerial, 1);
+BENCHMARK(MempoolAcceptBatch1Thread, 1);
+BENCHMARK(MempoolAcceptBatch2Threads, 1);
+BENCHMARK(MempoolAcceptBatch4Threads, 1);
+BENCHMARK(MempoolAcceptBatch8Threads, 1);
+BENCHMARK(MempoolAcceptBatch16Threads, 1);
@@ -6,7 +6,11 @@
 
 #include <uint256.h>
 #include <random.h>
+#include <checkqueue.h>
 #include <consensus/merkle.h>
+#include <validation.h>
+
+#include <boost/thread/thread.hpp>
 
 static void MerkleRoot(benchmark::State& state)
 {
@@ -23,4 +27,57 @@ static void MerkleRoot(benchmark::State& state)
     }
 }
 
+static CBlock CreateMerkleBenchBlock()
+{
+    CBlock block;
+    block.vtx.resize(9001);
+    for (size_t i = 0; i < block.vtx.size(); i++) {
+        CMutableTransaction mtx;
+        mtx.vin.resize(1);
+        mtx.vin[0].scriptSig = CScript() << OP_TRUE;
+        mtx.nLockTime = i;
+        block.vtx[i] = MakeTransactionRef(std::move(mtx));
+    }
+    return block;
+}
+
+// Both roots as CheckBlock used to compute them, one tree at a time.
+static void BlockMerkleRootTwice(benchmark::State& state)
+{
+    const CBlock block = CreateMerkleBenchBlock();
+    while (state.KeepRunning()) {
+        bool mutated = false;
+        uint256 root = BlockMerkleRoot(block, &mutated);
+        uint256 imRoot = BlockMerkleRoot(block, &mutated, true);
+        assert(root != imRoot && !mutated);
+    }
+}
+
+static void BlockDualMerkleRootThreads(benchmark::State& state, int nThreads)
+{
+    const CBlock block = CreateMerkleBenchBlock();
+
+    // The master thread joins the pool while waiting, so start one less.
+    CCheckQueue<CBlockMerkleCheck> queue(1);
+    boost::thread_group tg;
+    for (int i = 0; i < nThreads - 1; i++) {
+        tg.create_thread([&]{queue.Thread();});
+    }
+
+    while (state.KeepRunning()) {
+        bool mutated = false;
+        uint256 root, imRoot;
+        ComputeBlockMerkleRoots(block, root, imRoot, &mutated, nThreads > 1 ? &queue : nullptr);
+        assert(root != imRoot && !mutated);
+    }
+    tg.interrupt_all();
+    tg.join_all();
+}
+
+static void BlockDualMerkleRoot1Thread(benchmark::State& state) { BlockDualMerkleRootThreads(state, 1); }
+static void BlockDualMerkleRoot4Threads(benchmark::State& state) { BlockDualMerkleRootThreads(state, 4); }
+
 BENCHMARK(MerkleRoot, 800);
+BENCHMARK(BlockMerkleRootTwice, 400);
+BENCHMARK(BlockDualMerkleRoot1Thread, 400);
+BENCHMARK(BlockDualMerkleRoot4Threads, 400);
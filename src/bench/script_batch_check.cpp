@@ -0,0 +1,120 @@
+// Copyright (c) 2019 Chaintope Inc.
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+#include <key.h>
+#include <policy/policy.h>
+#include <primitives/transaction.h>
+#include <pubkey.h>
+#include <script/interpreter.h>
+#include <script/sigcache.h>
+#include <script/standard.h>
+#include <util.h>
+#include <validation.h>
+
+#include <vector>
+
+// Inputs of one Schnorr-heavy block: 64 transactions of 16 P2PKH inputs each.
+static const int TXS = 64;
+static const int INPUTS_PER_TX = 16;
+
+struct ScriptCheckBenchData {
+    CMutableTransaction txCredit;
+    std::vector<CTransaction> vtx;
+    std::vector<PrecomputedTransactionData> txdata;
+};
+
+static void CreateScriptCheckBenchData(ScriptCheckBenchData& data)
+{
+    CKey key;
+    key.MakeNewKey(true);
+    const CPubKey pubkey = key.GetPubKey();
+    const CScript scriptPubKey = GetScriptForDestination(pubkey.GetID());
+
+    data.txCredit.nFeatures = 1;
+    data.txCredit.vin.resize(1);
+    data.txCredit.vout.resize(TXS * INPUTS_PER_TX, CTxOut(1000, scriptPubKey));
+
+    std::vector<CMutableTransaction> vmtx(TXS);
+    for (int i = 0; i < TXS; i++) {
+        CMutableTransaction& mtx = vmtx[i];
+        mtx.nFeatures = 1;
+        mtx.vout.emplace_back(INPUTS_PER_TX * 1000, scriptPubKey);
+        for (int j = 0; j < INPUTS_PER_TX; j++) {
+            mtx.vin.emplace_back(COutPoint(data.txCredit.GetHashMalFix(), i * INPUTS_PER_TX + j));
+        }
+        for (int j = 0; j < INPUTS_PER_TX; j++) {
+            std::vector<unsigned char> vchSig;
+            bool ret = key.Sign_Schnorr(SignatureHash(scriptPubKey, mtx, j, SIGHASH_ALL, 1000, SigVersion::BASE), vchSig);
+            assert(ret);
+            vchSig.push_back(static_cast<unsigned char>(SIGHASH_ALL));
+            mtx.vin[j].scriptSig = CScript() << vchSig << ToByteVector(pubkey);
+        }
+    }
+
+    // Reserve so that the PrecomputedTransactionData pointers stay valid.
+    data.vtx.reserve(TXS);
+    data.txdata.reserve(TXS);
+    for (const CMutableTransaction& mtx : vmtx) {
+        data.vtx.emplace_back(mtx);
+        data.txdata.emplace_back(data.vtx.back());
+    }
+}
+
+static std::vector<CScriptCheck> CreateScriptChecks(ScriptCheckBenchData& data)
+{
+    std::vector<CScriptCheck> vChecks;
+    for (int i = 0; i < TXS; i++) {
+        for (int j = 0; j < INPUTS_PER_TX; j++) {
+            vChecks.emplace_back(data.txCredit.vout[i * INPUTS_PER_TX + j], data.vtx[i], j, STANDARD_SCRIPT_VERIFY_FLAGS, false, &data.txdata[i]);
+        }
+    }
+    return vChecks;
+}
+
+static void ScriptCheckSchnorrIndividual(benchmark::State& state)
+{
+    ECCVerifyHandle verify_handle;
+    InitSignatureCache();
+    ScriptCheckBenchData data;
+    CreateScriptCheckBenchData(data);
+    std::vector<CScriptCheck> vChecks = CreateScriptChecks(data);
+
+    while (state.KeepRunning()) {
+        for (CScriptCheck& check : vChecks) {
+            bool ret = check();
+            assert(ret);
+        }
+    }
+}
+
+static void ScriptCheckSchnorrBatched(benchmark::State& state)
+{
+    ECCVerifyHandle verify_handle;
+    InitSignatureCache();
+    ScriptCheckBenchData data;
+    CreateScriptCheckBenchData(data);
+    std::vector<CScriptCheck> vChecks = CreateScriptChecks(data);
+
+    // Group the inputs the way ConnectBlock hands them to the script check queue.
+    std::vector<CScriptBatchCheck> vBatchChecks;
+    for (size_t i = 0; i < vChecks.size(); i += BLOCK_SCRIPT_BATCH_SIZE) {
+        std::vector<CScriptCheck> vGroup;
+        for (size_t j = i; j < std::min(i + BLOCK_SCRIPT_BATCH_SIZE, vChecks.size()); j++) {
+            vGroup.emplace_back();
+            vGroup.back().swap(vChecks[j]);
+        }
+        vBatchChecks.emplace_back(vGroup);
+    }
+
+    while (state.KeepRunning()) {
+        for (CScriptBatchCheck& check : vBatchChecks) {
+            bool ret = check();
+            assert(ret);
+        }
+    }
+}
+
+BENCHMARK(ScriptCheckSchnorrIndividual, 2);
+BENCHMARK(ScriptCheckSchnorrBatched, 2);
@@ -0,0 +1,147 @@
+// Copyright (c) 2019 Chaintope Inc.
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+#include <key.h>
+#include <keystore.h>
+#include <policy/policy.h>
+#include <primitives/transaction.h>
+#include <pubkey.h>
+#include <script/interpreter.h>
+#include <script/sign.h>
+#include <script/standard.h>
+
+#include <vector>
+
+// A consolidation spending many P2PKH outputs of one key into two outputs,
+// where legacy signature hashing grows with the square of the input count.
+static const int LARGE_TX_INPUTS = 1000;
+
+struct LargeTxBenchData {
+    CBasicKeyStore keystore;
+    CPubKey pubkey;
+    CScript scriptPubKey;
+    CMutableTransaction mtx;
+};
+
+static void CreateLargeTxBenchData(LargeTxBenchData& data)
+{
+    CKey key;
+    key.MakeNewKey(true);
+    data.keystore.AddKey(key);
+    data.pubkey = key.GetPubKey();
+    data.scriptPubKey = GetScriptForDestination(data.pubkey.GetID());
+
+    CMutableTransaction txCredit;
+    txCredit.nFeatures = 1;
+    txCredit.vin.resize(1);
+    txCredit.vout.resize(LARGE_TX_INPUTS, CTxOut(1000, data.scriptPubKey));
+
+    data.mtx.nFeatures = 1;
+    for (int i = 0; i < LARGE_TX_INPUTS; i++) {
+        data.mtx.vin.emplace_back(COutPoint(txCredit.GetHashMalFix(), i));
+    }
+    data.mtx.vout.emplace_back(LARGE_TX_INPUTS * 500, data.scriptPubKey);
+    data.mtx.vout.emplace_back(LARGE_TX_INPUTS * 400, data.scriptPubKey);
+}
+
+static void SignLargeTx(LargeTxBenchData& data, const PrecomputedTransactionData* txdata)
+{
+    for (int i = 0; i < LARGE_TX_INPUTS; i++) {
+        SignatureData sigdata;
+        bool ret = ProduceSignature(data.keystore, MutableTransactionSignatureCreator(&data.mtx, i, 1000, SIGHASH_ALL, SignatureScheme::SCHNORR, txdata), data.scriptPubKey, sigdata);
+        assert(ret);
+        UpdateInput(data.mtx.vin[i], sigdata);
+    }
+}
+
+static void SighashLargeTx(benchmark::State& state)
+{
+    LargeTxBenchData data;
+    CreateLargeTxBenchData(data);
+
+    while (state.KeepRunning()) {
+        for (int i = 0; i < LARGE_TX_INPUTS; i++) {
+            SignatureHash(data.scriptPubKey, data.mtx, i, SIGHASH_ALL, 1000, SigVersion::BASE);
+        }
+    }
+}
+
+static void SighashLargeTxPrecomputed(benchmark::State& state)
+{
+    LargeTxBenchData data;
+    CreateLargeTxBenchData(data);
+
+    while (state.KeepRunning()) {
+        const PrecomputedTransactionData txdata(data.mtx);
+        for (int i = 0; i < LARGE_TX_INPUTS; i++) {
+            SignatureHash(data.scriptPubKey, data.mtx, i, SIGHASH_ALL, 1000, SigVersion::BASE, &txdata);
+        }
+    }
+}
+
+static void SignLargeTxSchnorr(benchmark::State& state)
+{
+    ECCVerifyHandle verify_handle;
+    LargeTxBenchData data;
+    CreateLargeTxBenchData(data);
+
+    while (state.KeepRunning()) {
+        const PrecomputedTransactionData txdata(data.mtx);
+        SignLargeTx(data, &txdata);
+    }
+}
+
+// Signing the whole transaction per iteration, so that the signing rate is
+// LARGE_TX_INPUTS divided by the time per iteration.
+static void SignLargeTxParallel(benchmark::State& state, int nThreads)
+{
+    ECCVerifyHandle verify_handle;
+    LargeTxBenchData data;
+    CreateLargeTxBenchData(data);
+    const CTxOut spent(1000, data.scriptPubKey);
+    const std::vector<const CTxOut*> vSpent(LARGE_TX_INPUTS, &spent);
+
+    while (state.KeepRunning()) {
+        const PrecomputedTransactionData txdata(data.mtx);
+        std::vector<SignatureData> vSigData(LARGE_TX_INPUTS);
+        ProduceSignatures(data.keystore, data.mtx, vSpent, SIGHASH_ALL, SignatureScheme::SCHNORR, &txdata, vSigData, nThreads);
+        for (int i = 0; i < LARGE_TX_INPUTS; i++) {
+            assert(vSigData[i].complete);
+            UpdateInput(data.mtx.vin[i], vSigData[i]);
+        }
+    }
+}
+
+static void SignLargeTxParallel1Thread(benchmark::State& state) { SignLargeTxParallel(state, 1); }
+static void SignLargeTxParallel2Threads(benchmark::State& state) { SignLargeTxParallel(state, 2); }
+static void SignLargeTxParallel4Threads(benchmark::State& state) { SignLargeTxParallel(state, 4); }
+static void SignLargeTxParallel8Threads(benchmark::State& state) { SignLargeTxParallel(state, 8); }
+
+static void VerifyLargeTxSchnorr(benchmark::State& state)
+{
+    ECCVerifyHandle verify_handle;
+    LargeTxBenchData data;
+    CreateLargeTxBenchData(data);
+    SignLargeTx(data, nullptr);
+    const CTransaction tx(data.mtx);
+
+    while (state.KeepRunning()) {
+        const PrecomputedTransactionData txdata(tx);
+        for (int i = 0; i < LARGE_TX_INPUTS; i++) {
+            ColorIdentifier colorId;
+            bool ret = VerifyScript(tx.vin[i].scriptSig, data.scriptPubKey, &tx.vin[i].scriptWitness, STANDARD_SCRIPT_VERIFY_FLAGS, TransactionSignatureChecker(&tx, i, 1000, txdata), colorId);
+            assert(ret);
+        }
+    }
+}
+
+BENCHMARK(SighashLargeTx, 5);
+BENCHMARK(SighashLargeTxPrecomputed, 5);
+BENCHMARK(SignLargeTxSchnorr, 1);
+BENCHMARK(SignLargeTxParallel1Thread, 1);
+BENCHMARK(SignLargeTxParallel2Threads, 1);
+BENCHMARK(SignLargeTxParallel4Threads, 1);
+BENCHMARK(SignLargeTxParallel8Threads, 1);
+BENCHMARK(VerifyLargeTxSchnorr, 1);
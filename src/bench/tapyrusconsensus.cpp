@@ -0,0 +1,87 @@
+// Copyright (c) 2019 Chaintope Inc.
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+#include <key.h>
+#include <primitives/transaction.h>
+#include <script/interpreter.h>
+#include <script/standard.h>
+#include <script/tapyrusconsensus.h>
+#include <streams.h>
+#include <version.h>
+
+#include <vector>
+
+// One large transaction checked through the library interface: 128 Schnorr
+// P2PKH inputs, a third of them spending a colored coin.
+static const int INPUTS = 128;
+
+struct ConsensusBenchData {
+    std::vector<unsigned char> vchTx;
+    std::vector<CScript> vScriptPubKey;
+    std::vector<bitcoinconsensus_spent_output> vSpent;
+};
+
+static void CreateConsensusBenchData(ConsensusBenchData& data)
+{
+    CKey key;
+    key.MakeNewKey(true);
+    const CPubKey pubkey = key.GetPubKey();
+    ColorIdentifier colorId(COutPoint(uint256S("1234"), 0), TokenTypes::REISSUABLE);
+
+    CMutableTransaction mtx;
+    mtx.nFeatures = 1;
+    for (int i = 0; i < INPUTS; i++) {
+        mtx.vin.emplace_back(COutPoint(uint256S("5678"), i));
+        data.vScriptPubKey.push_back(GetScriptForDestination(pubkey.GetID(), i % 3 == 2 ? &colorId : nullptr));
+    }
+    mtx.vout.emplace_back(INPUTS * 900, GetScriptForDestination(pubkey.GetID()));
+    for (int i = 0; i < INPUTS; i++) {
+        std::vector<unsigned char> vchSig;
+        bool ret = key.Sign_Schnorr(SignatureHash(data.vScriptPubKey[i], mtx, i, SIGHASH_ALL, 1000, SigVersion::BASE), vchSig);
+        assert(ret);
+        vchSig.push_back(static_cast<unsigned char>(SIGHASH_ALL));
+        mtx.vin[i].scriptSig = CScript() << vchSig << ToByteVector(pubkey);
+    }
+
+    CDataStream stream(SER_NETWORK, PROTOCOL_VERSION);
+    stream << mtx;
+    data.vchTx.assign(stream.begin(), stream.end());
+    for (const CScript& scriptPubKey : data.vScriptPubKey) {
+        data.vSpent.push_back({scriptPubKey.data(), (unsigned int)scriptPubKey.size(), 1000});
+    }
+}
+
+static void VerifyTransaction(benchmark::State& state, unsigned int options, unsigned int nThreads)
+{
+    ConsensusBenchData data;
+    CreateConsensusBenchData(data);
+    std::vector<int> vErrors(INPUTS);
+
+    while (state.KeepRunning()) {
+        bitcoinconsensus_error err;
+        int ret = bitcoinconsensus_verify_transaction(data.vchTx.data(), data.vchTx.size(), data.vSpent.data(), data.vSpent.size(),
+                                                      bitcoinconsensus_SCRIPT_FLAGS_VERIFY_NONE, options, nThreads, vErrors.data(), &err);
+        assert(ret == 1 && err == bitcoinconsensus_ERR_OK);
+    }
+}
+
+static void ConsensusVerifyTransaction(benchmark::State& state)
+{
+    VerifyTransaction(state, bitcoinconsensus_VERIFY_TX_NONE, 1);
+}
+
+static void ConsensusVerifyTransactionBatch(benchmark::State& state)
+{
+    VerifyTransaction(state, bitcoinconsensus_VERIFY_TX_BATCH_SCHNORR, 1);
+}
+
+static void ConsensusVerifyTransactionBatch4Threads(benchmark::State& state)
+{
+    VerifyTransaction(state, bitcoinconsensus_VERIFY_TX_BATCH_SCHNORR, 4);
+}
+
+BENCHMARK(ConsensusVerifyTransaction, 20);
+BENCHMARK(ConsensusVerifyTransactionBatch, 20);
+BENCHMARK(ConsensusVerifyTransactionBatch4Threads, 20);
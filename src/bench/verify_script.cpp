@@ -56,6 +56,7 @@ static void VerifyScriptBench(benchmark::State& state)
 {
     const int flags = SCRIPT_VERIFY_WITNESS ;
     const int witnessversion = 0;
+    ECCVerifyHandle verify_handle;
 
     // Keypair.
     CKey key;
@@ -109,4 +110,59 @@ static void VerifyScriptBench(benchmark::State& state)
     }
 }
 
+// Verification of P2PKH scripts with Schnorr signatures, over nKeys distinct
+// keys. Few keys are served from the parsed public key cache, while more keys
+// than the cache holds need the point decompression on every verification.
+static void VerifyScriptSchnorrKeys(benchmark::State& state, int nKeys)
+{
+    static const int SPENDS = 16384;
+    const int flags = SCRIPT_VERIFY_NONE;
+    ECCVerifyHandle verify_handle;
+
+    std::vector<CKey> keys(nKeys);
+    for (CKey& key : keys) {
+        key.MakeNewKey(true);
+    }
+
+    std::vector<CMutableTransaction> vtxCredit;
+    std::vector<CMutableTransaction> vtxSpend;
+    vtxCredit.reserve(SPENDS);
+    vtxSpend.reserve(SPENDS);
+    for (int i = 0; i < SPENDS; i++) {
+        const CKey& key = keys[i % nKeys];
+        const CPubKey pubkey = key.GetPubKey();
+        const CScript scriptPubKey = GetScriptForDestination(pubkey.GetID());
+        vtxCredit.push_back(BuildCreditingTransaction(scriptPubKey));
+        vtxCredit.back().vin[0].scriptSig << CScriptNum(i); // unique txids
+        vtxSpend.push_back(BuildSpendingTransaction(CScript(), vtxCredit.back()));
+        std::vector<unsigned char> vchSig;
+        key.Sign_Schnorr(SignatureHash(scriptPubKey, vtxSpend.back(), 0, SIGHASH_ALL, 1, SigVersion::BASE), vchSig);
+        vchSig.push_back(static_cast<unsigned char>(SIGHASH_ALL));
+        vtxSpend.back().vin[0].scriptSig = CScript() << vchSig << ToByteVector(pubkey);
+    }
+
+    ColorIdentifier colorId;
+    int i = 0;
+    while (state.KeepRunning()) {
+        const CMutableTransaction& txSpend = vtxSpend[i];
+        ScriptError err;
+        bool success = VerifyScript(
+            txSpend.vin[0].scriptSig,
+            vtxCredit[i].vout[0].scriptPubKey,
+            &txSpend.vin[0].scriptWitness,
+            flags,
+            MutableTransactionSignatureChecker(&txSpend, 0, vtxCredit[i].vout[0].nValue),
+            colorId,
+            &err);
+        assert(err == SCRIPT_ERR_OK);
+        assert(success);
+        i = (i + 1) % SPENDS;
+    }
+}
+
+static void VerifyScriptSchnorrReusedKeys(benchmark::State& state) { VerifyScriptSchnorrKeys(state, 16); }
+static void VerifyScriptSchnorrDistinctKeys(benchmark::State& state) { VerifyScriptSchnorrKeys(state, 16384); }
+
 BENCHMARK(VerifyScriptBench, 6300);
+BENCHMARK(VerifyScriptSchnorrReusedKeys, 6300);
+BENCHMARK(VerifyScriptSchnorrDistinctKeys, 6300);
@@ -6,6 +6,62 @@
 
 #include <chain.h>
 
+const std::vector<unsigned char>& CBlockIndex::GetXField() const
+{
+    static const std::vector<unsigned char> empty;
+    return pextra ? pextra->xfield : empty;
+}
+
+void CBlockIndex::SetXField(const std::vector<unsigned char>& xfield)
+{
+    static const std::vector<unsigned char> empty;
+    SetExtraData(xfield, pextra ? pextra->proof : empty);
+}
+
+std::vector<unsigned char> CBlockIndex::GetProof() const
+{
+    if (nProofSize == PROOF_OUT_OF_LINE)
+        return pextra->proof;
+    return std::vector<unsigned char>(vchProof, vchProof + nProofSize);
+}
+
+void CBlockIndex::SetProof(const std::vector<unsigned char>& proof)
+{
+    static const std::vector<unsigned char> empty;
+    if (proof.size() <= BLOCK_INDEX_INLINE_PROOF_SIZE) {
+        std::copy(proof.begin(), proof.end(), vchProof);
+        nProofSize = proof.size();
+        SetExtraData(GetXField(), empty);
+    } else {
+        nProofSize = PROOF_OUT_OF_LINE;
+        SetExtraData(GetXField(), proof);
+    }
+}
+
+void CBlockIndex::SetExtraData(const std::vector<unsigned char>& xfield, const std::vector<unsigned char>& proof)
+{
+    if (xfield.empty() && proof.empty()) {
+        pextra.reset();
+        return;
+    }
+    std::shared_ptr<CBlockIndexExtraData> extra = std::make_shared<CBlockIndexExtraData>();
+    extra->xfield = xfield;
+    extra->proof = proof;
+    pextra = std::move(extra);
+}
+
+void CBlockIndexArena::Clear()
+{
+    for (size_t i = 0; i < vSlabs.size(); i++) {
+        const size_t nEntries = (i + 1 == vSlabs.size()) ? nUsed : SLAB_SIZE;
+        for (size_t j = 0; j < nEntries; j++)
+            vSlabs[i][j].~CBlockIndex();
+        ::operator delete(vSlabs[i]);
+    }
+    vSlabs.clear();
+    nUsed = SLAB_SIZE;
+}
+
 /**
  * CChain implementation
  */
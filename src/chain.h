@@ -14,6 +14,7 @@
 #include <uint256.h>
 #include <utilstrencodings.h>
 
+#include <memory>
 #include <vector>
 
 /**
@@ -164,6 +165,17 @@ enum BlockStatus: uint32_t {
     BLOCK_OPT_WITNESS       =   128, //!< block data in blk*.data was received with a witness-enforcing client
 };
 
+/** Number of proof bytes a CBlockIndex stores inline: one Schnorr signature */
+static const unsigned int BLOCK_INDEX_INLINE_PROOF_SIZE = 64;
+
+/** Rare, variable sized parts of a block index entry, kept out of line */
+struct CBlockIndexExtraData
+{
+    std::vector<unsigned char> xfield;
+    //! Only set when the proof does not fit inline
+    std::vector<unsigned char> proof;
+};
+
 /** The block chain is a tree shaped structure starting with the
  * genesis block at the root, with each block potentially having multiple
  * candidates to be the next block. A blockindex may have multiple pprev pointing
@@ -211,15 +223,28 @@ public:
     uint256 hashImMerkleRoot;
     uint32_t nTime;
     uint8_t xfieldType;
-    std::vector<unsigned char> xfield;
-    std::vector<unsigned char> proof;
 
+private:
+    //! Marks a proof that does not fit in vchProof and lives in pextra
+    static const uint8_t PROOF_OUT_OF_LINE = 0xff;
+
+    //! Size of the proof stored in vchProof, or PROOF_OUT_OF_LINE
+    uint8_t nProofSize;
+    //! Block proof, inline as every valid proof fits
+    unsigned char vchProof[BLOCK_INDEX_INLINE_PROOF_SIZE];
+    //! xfield and oversized proof, nullptr when there are none. Never modified in place
+    std::shared_ptr<const CBlockIndexExtraData> pextra;
+
+    void SetExtraData(const std::vector<unsigned char>& xfield, const std::vector<unsigned char>& proof);
+
+public:
     //! (memory only) Sequential id assigned to distinguish order in which blocks are received.
     int32_t nSequenceId;
 
     //! (memory only) Maximum nTime in the chain up to and including this block.
     unsigned int nTimeMax;
 
+
     void SetNull()
     {
         phashBlock = nullptr;
@@ -239,8 +264,8 @@ public:
         hashMerkleRoot = uint256();
         nTime          = 0;
         xfieldType          = 0;
-        xfield.clear();
-        proof.clear();
+        nProofSize = 0;
+        pextra.reset();
     }
 
     CBlockIndex()
@@ -257,8 +282,21 @@ public:
         hashImMerkleRoot = block.hashImMerkleRoot;
         nTime          = block.nTime;
         xfieldType          = block.xfieldType;
-        xfield         = block.xfield;
-        proof          = block.proof;
+        SetXField(block.xfield);
+        SetProof(block.proof);
+    }
+
+    const std::vector<unsigned char>& GetXField() const;
+    void SetXField(const std::vector<unsigned char>& xfield);
+    std::vector<unsigned char> GetProof() const;
+    void SetProof(const std::vector<unsigned char>& proof);
+
+    //! Copy the xfield and proof of another entry, sharing its out of line data
+    void CopyXFieldAndProof(const CBlockIndex& other)
+    {
+        nProofSize = other.nProofSize;
+        std::copy(other.vchProof, other.vchProof + BLOCK_INDEX_INLINE_PROOF_SIZE, vchProof);
+        pextra = other.pextra;
     }
 
     CDiskBlockPos GetBlockPos() const {
@@ -289,8 +327,8 @@ public:
         block.hashImMerkleRoot = hashImMerkleRoot;
         block.nTime          = nTime;
         block.xfieldType          = xfieldType;
-        block.xfield         = xfield;
-        block.proof          = proof;
+        block.xfield         = GetXField();
+        block.proof          = GetProof();
         return block;
     }
 
@@ -333,8 +371,8 @@ public:
             hashImMerkleRoot.ToString(),
             nTime,
             xfieldType,
-            HexStr(xfield),
-            HexStr(proof),
+            HexStr(GetXField()),
+            HexStr(GetProof()),
             GetBlockHash().ToString());
     }
 
@@ -369,6 +407,45 @@ public:
     const CBlockIndex* GetAncestor(int height) const;
 };
 
+/**
+ * Allocates CBlockIndex entries in slabs rather than with one heap
+ * allocation each. Entries are only destroyed all together, by Clear() or
+ * the destructor, which is how the block index is torn down anyway.
+ */
+class CBlockIndexArena
+{
+public:
+    //! Number of entries per slab
+    static const size_t SLAB_SIZE = 4096;
+
+    CBlockIndexArena() : nUsed(SLAB_SIZE) {}
+    CBlockIndexArena(const CBlockIndexArena&) = delete;
+    CBlockIndexArena& operator=(const CBlockIndexArena&) = delete;
+    ~CBlockIndexArena() { Clear(); }
+
+    template <typename... Args>
+    CBlockIndex* Create(Args&&... args)
+    {
+        if (nUsed == SLAB_SIZE) {
+            vSlabs.emplace_back(static_cast<CBlockIndex*>(::operator new(SLAB_SIZE * sizeof(CBlockIndex))));
+            nUsed = 0;
+        }
+        CBlockIndex* pindex = new (vSlabs.back() + nUsed) CBlockIndex(std::forward<Args>(args)...);
+        nUsed++;
+        return pindex;
+    }
+
+    //! Destroy every entry created by this arena
+    void Clear();
+
+    size_t size() const { return vSlabs.empty() ? 0 : (vSlabs.size() - 1) * SLAB_SIZE + nUsed; }
+
+private:
+    std::vector<CBlockIndex*> vSlabs;
+    //! Number of entries created in the last slab
+    size_t nUsed;
+};
+
 /** Find the forking point between two chain tips. */
 const CBlockIndex* LastCommonAncestor(const CBlockIndex* pa, const CBlockIndex* pb);
 
@@ -412,9 +489,19 @@ public:
         READWRITE(hashImMerkleRoot);
         READWRITE(nTime);
         READWRITE(xfieldType);
+        std::vector<unsigned char> xfield;
+        std::vector<unsigned char> proof;
+        if (!ser_action.ForRead()) {
+            xfield = GetXField();
+            proof = GetProof();
+        }
         if((TAPYRUS_XFIELDTYPES)xfieldType != TAPYRUS_XFIELDTYPES::NONE)
             READWRITE(xfield);
         READWRITE(proof);
+        if (ser_action.ForRead()) {
+            SetXField(xfield);
+            SetProof(proof);
+        }
     }
 
     uint256 GetBlockHash() const
@@ -426,8 +513,8 @@ public:
         block.hashImMerkleRoot  = hashImMerkleRoot;
         block.nTime           = nTime;
         block.xfieldType          = xfieldType;
-        block.xfield         = xfield;
-        block.proof           = proof;
+        block.xfield         = GetXField();
+        block.proof           = GetProof();
         return block.GetHash();
     }
 
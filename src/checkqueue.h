@@ -8,6 +8,7 @@
 #include <sync.h>
 
 #include <algorithm>
+#include <atomic>
 #include <vector>
 
 #include <boost/thread/condition_variable.hpp>
@@ -25,12 +26,31 @@ class CCheckQueueControl;
   * onto the queue, where they are processed by N-1 worker threads. When
   * the master is done adding work, it temporarily joins the worker pool
   * as an N'th worker, until all jobs are done.
+  *
+  * Queued verifications are spread over per-worker shards, each with its own
+  * lock. A worker takes work from the back of its own shard and, once that is
+  * empty, steals from the front of the others, so workers and the master only
+  * contend when they touch the same shard. The global mutex is only taken to
+  * sleep and to wake up.
   */
 template <typename T>
 class CCheckQueue
 {
 private:
-    //! Mutex to protect the inner state
+    //! Number of shards; workers beyond this share shards.
+    static const unsigned int SHARDS = 64;
+
+    struct Shard {
+        boost::mutex mutex;
+        //! Elements before nBegin were stolen and are left as empty placeholders.
+        std::vector<T> checks;
+        size_t nBegin = 0;
+    };
+
+    //! Per-worker queues of elements to be processed. Shard 0 belongs to the master.
+    Shard shards[SHARDS];
+
+    //! Mutex to protect sleeping and waking up
     boost::mutex mutex;
 
     //! Worker threads block on this when out of work
@@ -39,87 +59,126 @@ private:
     //! Master thread blocks on this when out of work
     boost::condition_variable condMaster;
 
-    //! The queue of elements to be processed.
-    //! As the order of booleans doesn't matter, it is used as a LIFO (stack)
-    std::vector<T> queue;
+    //! Number of elements in the shards, counted before they are added and
+    //! after they are removed so that it never falls behind the actual number.
+    std::atomic<int64_t> nQueued;
 
-    //! The number of workers (including the master) that are idle.
-    int nIdle;
+    //! The number of workers that are idle.
+    std::atomic<int> nIdle;
 
-    //! The total number of workers (including the master).
-    int nTotal;
+    //! The number of worker threads that have started, excluding the master.
+    std::atomic<unsigned int> nWorkers;
+
+    //! Shard the next added batch starts filling, to spread small batches.
+    unsigned int nNextShard;
 
     //! The temporary evaluation result.
-    bool fAllOk;
+    std::atomic<bool> fAllOk;
 
     /**
      * Number of verifications that haven't completed yet.
      * This includes elements that are no longer queued, but still in the
      * worker's own batches.
      */
-    unsigned int nTodo;
+    std::atomic<int64_t> nTodo;
 
     //! The maximum number of elements to be processed in one batch
     unsigned int nBatchSize;
 
+    unsigned int ActiveShards() const
+    {
+        const unsigned int nShards = nWorkers.load() + 1;
+        return nShards < SHARDS ? nShards : SHARDS;
+    }
+
+    /**
+     * Move a batch of elements out of shard into vChecks. Half of the shard
+     * is taken, up to nBatchSize, leaving the rest to other workers: from the
+     * back if it is the worker's own shard, from the front when stealing.
+     */
+    bool TakeFromShard(Shard& shard, std::vector<T>& vChecks, bool fSteal)
+    {
+        boost::unique_lock<boost::mutex> lock(shard.mutex);
+        const size_t nSize = shard.checks.size() - shard.nBegin;
+        if (nSize == 0)
+            return false;
+        const size_t nNow = std::max<size_t>(1, std::min<size_t>(nBatchSize, nSize / 2));
+        vChecks.resize(nNow);
+        for (size_t i = 0; i < nNow; i++) {
+            // Swap jobs out of the shard instead of copying, to keep the lock short.
+            if (fSteal) {
+                vChecks[i].swap(shard.checks[shard.nBegin++]);
+            } else {
+                vChecks[i].swap(shard.checks.back());
+                shard.checks.pop_back();
+            }
+        }
+        if (shard.nBegin == shard.checks.size()) {
+            shard.checks.clear();
+            shard.nBegin = 0;
+        }
+        nQueued -= nNow;
+        return true;
+    }
+
+    bool TakeChecks(unsigned int nShard, std::vector<T>& vChecks)
+    {
+        if (nQueued.load() <= 0)
+            return false;
+        if (TakeFromShard(shards[nShard], vChecks, false))
+            return true;
+        const unsigned int nShards = ActiveShards();
+        for (unsigned int i = 1; i < nShards; i++) {
+            if (TakeFromShard(shards[(nShard + i) % nShards], vChecks, true))
+                return true;
+        }
+        return false;
+    }
+
     /** Internal function that does bulk of the verification work. */
-    bool Loop(bool fMaster = false)
+    bool Loop(bool fMaster, unsigned int nShard)
     {
-        boost::condition_variable& cond = fMaster ? condMaster : condWorker;
         std::vector<T> vChecks;
         vChecks.reserve(nBatchSize);
-        unsigned int nNow = 0;
-        bool fOk = true;
         do {
-            {
-                boost::unique_lock<boost::mutex> lock(mutex);
-                // first do the clean-up of the previous loop run (allowing us to do it in the same critsect)
-                if (nNow) {
-                    fAllOk &= fOk;
-                    nTodo -= nNow;
-                    if (nTodo == 0 && !fMaster)
-                        // We processed the last element; inform the master it can exit and return the result
-                        condMaster.notify_one();
-                } else {
-                    // first iteration
-                    nTotal++;
-                }
-                // logically, the do loop starts here
-                while (queue.empty()) {
-                    if (fMaster && nTodo == 0) {
-                        nTotal--;
-                        bool fRet = fAllOk;
-                        // reset the status for new work later
-                        if (fMaster)
-                            fAllOk = true;
-                        // return the current status
-                        return fRet;
-                    }
-                    nIdle++;
-                    cond.wait(lock); // wait
-                    nIdle--;
+            if (TakeChecks(nShard, vChecks)) {
+                // Check whether we need to do work at all
+                bool fOk = fAllOk.load();
+                for (T& check : vChecks)
+                    if (fOk)
+                        fOk = check();
+                const int64_t nNow = vChecks.size();
+                // The checks must be gone before nTodo says they are done.
+                vChecks.clear();
+                if (!fOk)
+                    fAllOk = false;
+                if (nTodo.fetch_sub(nNow) == nNow && !fMaster) {
+                    // We processed the last element; inform the master it can exit and return the result
+                    boost::unique_lock<boost::mutex> lock(mutex);
+                    condMaster.notify_one();
                 }
-                // Decide how many work units to process now.
-                // * Do not try to do everything at once, but aim for increasingly smaller batches so
-                //   all workers finish approximately simultaneously.
-                // * Try to account for idle jobs which will instantly start helping.
-                // * Don't do batches smaller than 1 (duh), or larger than nBatchSize.
-                nNow = std::max(1U, std::min(nBatchSize, (unsigned int)queue.size() / (nTotal + nIdle + 1)));
-                vChecks.resize(nNow);
-                for (unsigned int i = 0; i < nNow; i++) {
-                    // We want the lock on the mutex to be as short as possible, so swap jobs from the global
-                    // queue to the local batch vector instead of copying.
-                    vChecks[i].swap(queue.back());
-                    queue.pop_back();
+                continue;
+            }
+
+            boost::unique_lock<boost::mutex> lock(mutex);
+            if (fMaster) {
+                if (nTodo.load() == 0) {
+                    bool fRet = fAllOk;
+                    // reset the status for new work later
+                    fAllOk = true;
+                    // return the current status
+                    return fRet;
                 }
-                // Check whether we need to do work at all
-                fOk = fAllOk;
+                if (nQueued.load() <= 0)
+                    condMaster.wait(lock);
+            } else {
+                // Announce being idle before looking at nQueued; Add does the
+                // reverse, so either we see its work or it sees us and wakes us.
+                nIdle++;
+                if (nQueued.load() <= 0)
+                    condWorker.wait(lock);
+                nIdle--;
             }
-            // execute work
-            for (T& check : vChecks)
-                if (fOk)
-                    fOk = check();
-            vChecks.clear();
         } while (true);
     }
 
@@ -128,33 +187,50 @@ public:
     boost::mutex ControlMutex;
 
     //! Create a new check queue
-    explicit CCheckQueue(unsigned int nBatchSizeIn) : nIdle(0), nTotal(0), fAllOk(true), nTodo(0), nBatchSize(nBatchSizeIn) {}
+    explicit CCheckQueue(unsigned int nBatchSizeIn) : nQueued(0), nIdle(0), nWorkers(0), nNextShard(0), fAllOk(true), nTodo(0), nBatchSize(nBatchSizeIn) {}
 
     //! Worker thread
     void Thread()
     {
-        Loop();
+        const unsigned int nShard = 1 + nWorkers++ % (SHARDS - 1);
+        Loop(false, nShard);
     }
 
     //! Wait until execution finishes, and return whether all evaluations were successful.
     bool Wait()
     {
-        return Loop(true);
+        return Loop(true, 0);
     }
 
     //! Add a batch of checks to the queue
     void Add(std::vector<T>& vChecks)
     {
-        boost::unique_lock<boost::mutex> lock(mutex);
-        for (T& check : vChecks) {
-            queue.push_back(T());
-            check.swap(queue.back());
-        }
+        if (vChecks.empty())
+            return;
         nTodo += vChecks.size();
-        if (vChecks.size() == 1)
-            condWorker.notify_one();
-        else if (vChecks.size() > 1)
-            condWorker.notify_all();
+        nQueued += vChecks.size();
+
+        // Deal the checks out over the shards in contiguous runs.
+        const unsigned int nShards = ActiveShards();
+        const size_t nPerShard = (vChecks.size() + nShards - 1) / nShards;
+        for (size_t nBegin = 0; nBegin < vChecks.size(); nBegin += nPerShard) {
+            nNextShard %= nShards;
+            Shard& shard = shards[nNextShard++];
+            const size_t nEnd = std::min(vChecks.size(), nBegin + nPerShard);
+            boost::unique_lock<boost::mutex> lock(shard.mutex);
+            for (size_t i = nBegin; i < nEnd; i++) {
+                shard.checks.push_back(T());
+                vChecks[i].swap(shard.checks.back());
+            }
+        }
+
+        if (nIdle.load() > 0) {
+            boost::unique_lock<boost::mutex> lock(mutex);
+            if (vChecks.size() == 1)
+                condWorker.notify_one();
+            else
+                condWorker.notify_all();
+        }
     }
 
     ~CCheckQueue()
@@ -8,21 +8,19 @@
 
 ColorIdentifier GetColorIdFromScript(const CScript& script)
 {
-    if(!script.IsColoredScript())
+    //the standard colored scripts start with the color id
+    const ScriptTemplateMatch match = MatchScriptTemplate(script);
+    if(match.colorid)
+        return ColorIdentifier(match.colorid, match.colorid + 33);
+    if(match.type != ScriptTemplate::NONE)
         return ColorIdentifier();
 
-    std::vector<unsigned char> pubkeyhash, colorId;
-    if( MatchColoredPayToPubkeyHash(script, pubkeyhash, colorId))
-        return ColorIdentifier(colorId);
-
-    if(script.IsColoredPayToScriptHash())
-    {
-        colorId.assign(script.begin()+1, script.begin()+34);
-        return ColorIdentifier(colorId);
-    }
+    if(!script.IsColoredScript())
+        return ColorIdentifier();
 
+    std::vector<unsigned char> colorId;
     if(MatchCustomColoredScript(script, colorId))
         return ColorIdentifier(colorId);
 
     return ColorIdentifier();
-}
\ No newline at end of file
+}
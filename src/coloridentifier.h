@@ -4,7 +4,9 @@
 #ifndef TAPYRUS_COLORIDENTIFIER_H
 #define TAPYRUS_COLORIDENTIFIER_H
 
+#include <crypto/common.h>
 #include <crypto/sha256.h>
+#include <smallmap.h>
 #include <streams.h>
 #include <version.h>
 #include <amount.h>
@@ -49,27 +51,24 @@ struct ColorIdentifier
 
     ColorIdentifier():type(TokenTypes::NONE), payload{} { }
 
-    ColorIdentifier(COutPoint &utxoIn, TokenTypes typeIn):type(typeIn), payload{} {
-        CDataStream s(SER_NETWORK, INIT_PROTO_VERSION);
-        s << utxoIn;
-        CSHA256().Write((unsigned char *)s.data(), s.size()).Finalize(payload);
+    ColorIdentifier(const COutPoint &utxoIn, TokenTypes typeIn):type(typeIn), payload{} {
+        //hash the outpoint as serialized: hashMalFix followed by n in little endian
+        unsigned char serialized[36];
+        memcpy(serialized, utxoIn.hashMalFix.begin(), 32);
+        WriteLE32(serialized + 32, utxoIn.n);
+        CSHA256().Write(serialized, sizeof(serialized)).Finalize(payload);
     }
 
     ColorIdentifier(const CScript& input):type(TokenTypes::REISSUABLE), payload{} {
-        std::vector<unsigned char> scriptVector(input.begin(), input.end());
-        CSHA256().Write(scriptVector.data(), scriptVector.size()).Finalize(payload);
+        CSHA256().Write(input.data(), input.size()).Finalize(payload);
     }
 
-    ColorIdentifier(const unsigned char* pbegin, const unsigned char* pend):type(UintToToken(*pbegin)) {
-        CSerActionUnserialize ser_action;
-        CDataStream s((const char*)pbegin, (const char*)pend, SER_NETWORK, INIT_PROTO_VERSION);
-        SerializationOp(s, ser_action);
+    ColorIdentifier(const unsigned char* pbegin, const unsigned char* pend):type(TokenTypes::NONE), payload{} {
+        Parse(pbegin, pend);
     }
 
-    ColorIdentifier(const std::vector<unsigned char>& in) {
-        CSerActionUnserialize ser_action;
-        CDataStream s(in, SER_NETWORK, INIT_PROTO_VERSION);
-        SerializationOp(s, ser_action);
+    ColorIdentifier(const std::vector<unsigned char>& in):type(TokenTypes::NONE), payload{} {
+        Parse(in.data(), in.data() + in.size());
     }
 
     bool operator==(const ColorIdentifier& colorId) const {
@@ -101,9 +100,26 @@ struct ColorIdentifier
     }
 
     inline std::vector<unsigned char> toVector() const {
-        CDataStream stream(SER_NETWORK, INIT_PROTO_VERSION);
-        this->Serialize(stream);
-        return std::vector<unsigned char>(stream.begin(), stream.end());
+        std::vector<unsigned char> vch;
+        vch.reserve(1 + sizeof(payload));
+        vch.push_back(TokenToUint(type));
+        if(type >= TokenTypes::REISSUABLE && type <= TokenTypes::TOKENTYPE_MAX)
+            vch.insert(vch.end(), payload, payload + sizeof(payload));
+        return vch;
+    }
+
+private:
+    //same as unserializing from a stream, without one
+    void Parse(const unsigned char* pbegin, const unsigned char* pend) {
+        if(pbegin == pend)
+            throw std::ios_base::failure("ColorIdentifier::Parse(): end of data");
+        type = UintToToken(*pbegin);
+        if(type >= TokenTypes::REISSUABLE && type <= TokenTypes::TOKENTYPE_MAX)
+        {
+            if(pend - pbegin < 1 + (ptrdiff_t)sizeof(payload))
+                throw std::ios_base::failure("ColorIdentifier::Parse(): end of data");
+            memcpy(payload, pbegin + 1, sizeof(payload));
+        }
     }
 
 };
@@ -121,7 +137,23 @@ struct ColorIdentifierCompare
     }
 };
 
-typedef std::map<ColorIdentifier, CAmount, ColorIdentifierCompare> TxColoredCoinBalancesMap;
+//almost every transaction moves one or two colors, including TPC, so their
+//balances are kept inline in a sorted vector rather than in a tree
 
+typedef smallmap<2, ColorIdentifier, CAmount, ColorIdentifierCompare> TxColoredCoinBalancesMap;
+
+//the payload is already a SHA256 hash, so part of it is enough to
+//key unordered containers of color ids
+
+namespace std {
+template <>
+struct hash<ColorIdentifier>
+{
+    size_t operator()(const ColorIdentifier& c) const
+    {
+        return ReadLE64(&c.payload[0]) ^ TokenToUint(c.type);
+    }
+};
+} // namespace std
 
 #endif //TAPYRUS_COLORIDENTIFIER_H
\ No newline at end of file
@@ -77,6 +77,61 @@ uint256 BlockMerkleRoot(const CBlock& block, bool* mutated, const bool immutable
     return ComputeMerkleRoot(std::move(leaves), mutated);
 }
 
+/*
+ * hashes holds the count nodes of one tree followed by the count nodes of the
+ * other. Hash both trees up by nDepth levels (or up to their roots if nDepth
+ * is negative), one SHA256D64 call per level for both.
+ */
+static void ReduceDualMerkleTree(std::vector<uint256>& hashes, size_t count, int nDepth, bool* mutated)
+{
+    bool mutation = false;
+    for (int level = 0; nDepth < 0 ? count > 1 : level < nDepth; level++) {
+        if (mutated) {
+            for (size_t pos = 0; pos + 1 < count; pos += 2) {
+                if (hashes[pos] == hashes[pos + 1] || hashes[count + pos] == hashes[count + pos + 1]) mutation = true;
+            }
+        }
+        if (count & 1) {
+            // Duplicate the last node of both trees, keeping the second tree
+            // right behind the first.
+            const uint256 last = hashes[count - 1];
+            hashes.insert(hashes.begin() + count, last);
+            hashes.push_back(hashes.back());
+            count++;
+        }
+        SHA256D64(hashes[0].begin(), hashes[0].begin(), count);
+        count /= 2;
+        hashes.resize(count * 2);
+    }
+    if (mutated) *mutated = mutation;
+}
+
+void BlockDualMerkleSubtree(const CBlock& block, size_t begin, size_t end, int nDepth, uint256& node, uint256& imNode, bool* mutated)
+{
+    const size_t count = end - begin;
+    std::vector<uint256> hashes;
+    hashes.reserve(count * 2 + 2);
+    hashes.resize(count * 2);
+    for (size_t s = 0; s < count; s++) {
+        hashes[s] = block.vtx[begin + s]->GetHash();
+        hashes[count + s] = block.vtx[begin + s]->GetHashMalFix();
+    }
+    ReduceDualMerkleTree(hashes, count, nDepth, mutated);
+    node = hashes[0];
+    imNode = hashes[1];
+}
+
+void BlockDualMerkleRoot(const CBlock& block, uint256& root, uint256& imRoot, bool* mutated)
+{
+    if (block.vtx.empty()) {
+        if (mutated) *mutated = false;
+        root.SetNull();
+        imRoot.SetNull();
+        return;
+    }
+    BlockDualMerkleSubtree(block, 0, block.vtx.size(), -1, root, imRoot, mutated);
+}
+
 uint256 BlockWitnessMerkleRoot(const CBlock& block, bool* mutated)
 {
     std::vector<uint256> leaves;
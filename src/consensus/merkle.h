@@ -21,6 +21,22 @@ uint256 ComputeMerkleRoot(std::vector<uint256> hashes, bool* mutated = nullptr);
  */
 uint256 BlockMerkleRoot(const CBlock& block, bool* mutated = nullptr, const bool immutable=false);
 
+/*
+ * Compute the Merkle roots of the transaction hashes and of the MalFix hashes
+ * of a block in one pass, hashing the matching levels of both trees together.
+ * *mutated is set to true if a duplicated subtree was found in either tree.
+ */
+void BlockDualMerkleRoot(const CBlock& block, uint256& root, uint256& imRoot, bool* mutated = nullptr);
+
+/*
+ * Compute the nodes nDepth levels above the leaves [begin, end) in both trees
+ * of BlockDualMerkleRoot, so that a large block can be split into subtrees
+ * hashed independently. begin must be a multiple of 2^nDepth and end - begin
+ * must be between 1 and 2^nDepth.
+ * *mutated is set to true if a duplicated subtree was found in either tree.
+ */
+void BlockDualMerkleSubtree(const CBlock& block, size_t begin, size_t end, int nDepth, uint256& node, uint256& imNode, bool* mutated = nullptr);
+
 /*
  * Compute the Merkle root of the witness transactions in a block.
  * *mutated is set to true if a duplicated subtree was found.
@@ -13,6 +13,9 @@
 #include <memory>
 #include <vector>
 
+#include <boost/thread/locks.hpp>
+#include <boost/thread/shared_mutex.hpp>
+
 
 /** namespace CuckooCache provides high performance cache primitives
  *
@@ -23,6 +26,9 @@
  * 2) cache is a cache which is performant in memory usage and lookup speed. It
  * is lockfree for erase operations. Elements are lazily erased on the next
  * insert.
+ *
+ * 3) sharded_cache splits a cache into independently locked shards so that it
+ * can be shared between threads without external locking.
  */
 namespace CuckooCache
 {
@@ -476,6 +482,87 @@ public:
         return false;
     }
 };
+
+/** sharded_cache spreads elements over Shards independent caches, each
+ * guarded by its own shared mutex. Lookups (including erases) take a shared
+ * lock and inserts a unique lock on one shard only, so threads checking or
+ * storing different elements rarely wait for each other and callers need no
+ * external locking.
+ *
+ * The shard of an element is picked from the low bits of its first hash,
+ * while each shard indexes its table by the high bits of the same hashes.
+ *
+ * @tparam Shards the number of shards; setup() divides the size evenly.
+ */
+template <typename Element, typename Hash, uint32_t Shards = 16>
+class sharded_cache
+{
+private:
+    struct shard {
+        cache<Element, Hash> set;
+        mutable boost::shared_mutex mutex;
+    };
+
+    std::array<shard, Shards> shards;
+
+    const Hash hash_function;
+
+    shard& shard_for(const Element& e)
+    {
+        return shards[hash_function.template operator()<0>(e) % Shards];
+    }
+
+    const shard& shard_for(const Element& e) const
+    {
+        return shards[hash_function.template operator()<0>(e) % Shards];
+    }
+
+public:
+    sharded_cache() : shards(), hash_function()
+    {
+    }
+
+    /** setup initializes every shard to hold new_size / Shards elements
+     *
+     * @param new_size the desired total number of elements to store
+     * @returns the total number of elements storable
+     */
+    uint32_t setup(uint32_t new_size)
+    {
+        uint32_t total = 0;
+        for (shard& s : shards) {
+            boost::unique_lock<boost::shared_mutex> lock(s.mutex);
+            total += s.set.setup(new_size / Shards);
+        }
+        return total;
+    }
+
+    /** setup_bytes is a convenience function which accounts for internal memory
+     * usage when deciding how many elements to store. See cache::setup_bytes.
+     */
+    uint32_t setup_bytes(size_t bytes)
+    {
+        return setup(bytes/sizeof(Element));
+    }
+
+    /** insert loads the element e into the shard it belongs to. See cache::insert. */
+    inline void insert(Element e)
+    {
+        shard& s = shard_for(e);
+        boost::unique_lock<boost::shared_mutex> lock(s.mutex);
+        s.set.insert(std::move(e));
+    }
+
+    /** contains checks whether e is in its shard, marking it erased if erase
+     * is set. See cache::contains.
+     */
+    inline bool contains(const Element& e, const bool erase) const
+    {
+        const shard& s = shard_for(e);
+        boost::shared_lock<boost::shared_mutex> lock(s.mutex);
+        return s.set.contains(e, erase);
+    }
+};
 } // namespace CuckooCache
 
 #endif // BITCOIN_CUCKOOCACHE_H
@@ -115,7 +115,7 @@ void SelectFederationParams(const TAPYRUS_OP_MODE mode, const bool withGenesis)
     globalChainFederationParams = CreateFederationParams(mode, withGenesis);
 }
 
-CFederationParams::CFederationParams(const int networkId, const std::string dataDirName, const std::string genesisHex) : nNetworkId(networkId), strNetworkID(std::to_string(networkId)), dataDir(dataDirName) {
+CFederationParams::CFederationParams(const int networkId, const std::string dataDirName, const std::string genesisHex) : nNetworkId(networkId), strNetworkID(std::to_string(networkId)), dataDir(dataDirName), aggregatePubkeyIndex(std::make_shared<CAggregatePubkeyIndex>()) {
 
     /**
      * The message start string is designed to be unlikely to occur in normal data.
@@ -159,7 +159,18 @@ CPubKey CFederationParams::ReadAggregatePubkey(const std::vector<unsigned char>&
             throw std::runtime_error(strprintf("Aggregate Public Key for Signed Block is invalid: %s", HexStr(pubkey)));
         }
 
-        aggregatePubkeyHeight.push_back(p);
+        // The new key supersedes whatever was in effect from its height on.
+        std::shared_ptr<const CAggregatePubkeyIndex> current = GetAggregatePubkeyIndex();
+        std::shared_ptr<const CAggregatePubkeyIndex> next;
+        do {
+            std::vector<aggPubkeyAndHeight> list;
+            for (const aggPubkeyAndHeight& c : current->GetList()) {
+                if (c.height < p.height)
+                    list.push_back(c);
+            }
+            list.push_back(p);
+            next = std::make_shared<CAggregatePubkeyIndex>(std::move(list), current->GetVersion() + 1);
+        } while (!std::atomic_compare_exchange_strong(&aggregatePubkeyIndex, &current, next));
 
         return p.aggpubkey;
 
@@ -170,6 +181,25 @@ CPubKey CFederationParams::ReadAggregatePubkey(const std::vector<unsigned char>&
     }
 }
 
+void CFederationParams::RemoveAggregatePubkeysFromHeight(uint height) const
+{
+    std::shared_ptr<const CAggregatePubkeyIndex> current = GetAggregatePubkeyIndex();
+    std::shared_ptr<const CAggregatePubkeyIndex> next;
+    do {
+        const std::vector<aggPubkeyAndHeight>& currentList = current->GetList();
+        // The genesis key is never removed.
+        if (currentList.size() <= 1 || currentList.back().height < (int)height)
+            return;
+
+        std::vector<aggPubkeyAndHeight> list;
+        for (const aggPubkeyAndHeight& c : currentList) {
+            if (c.height < (int)height || list.empty())
+                list.push_back(c);
+        }
+        next = std::make_shared<CAggregatePubkeyIndex>(std::move(list), current->GetVersion() + 1);
+    } while (!std::atomic_compare_exchange_strong(&aggregatePubkeyIndex, &current, next));
+}
+
 bool CFederationParams::ReadGenesisBlock(std::string genesisHex)
 {
     CDataStream ss(ParseHex(genesisHex), SER_NETWORK, PROTOCOL_VERSION);
@@ -211,31 +241,42 @@ bool CFederationParams::ReadGenesisBlock(std::string genesisHex)
 
     //verify proof
     const uint256 blockHash = genesis.GetHashForSign();
-    if(!aggregatePubkeyHeight.back().aggpubkey.Verify_Schnorr(blockHash, genesis.proof))
+    if(!GetLatestAggregatePubkey().Verify_Schnorr(blockHash, genesis.proof))
         throw std::runtime_error("ReadGenesisBlock: Proof verification failed");
 
     return true;
 }
 
-int CFederationParams::GetHeightFromAggregatePubkey(const CPubKey &aggpubkey) const
+CAggregatePubkeyIndex::CAggregatePubkeyIndex(std::vector<aggPubkeyAndHeight> listIn, uint64_t nVersionIn) : vList(std::move(listIn)), nVersion(nVersionIn)
 {
-    for (auto& c : aggregatePubkeyHeight) {
-        if (c.aggpubkey == aggpubkey)
-            return c.height;
-    }
-    return -1;
+    mapHeight.reserve(vList.size());
+    // a federation can return to an earlier key, keep the first height it was used from
+    for (const aggPubkeyAndHeight& c : vList)
+        mapHeight.emplace(c.aggpubkey, c.height);
+}
+
+CPubKey CAggregatePubkeyIndex::GetLatest() const
+{
+    return vList.empty() ? CPubKey() : vList.back().aggpubkey;
 }
 
-CPubKey& CFederationParams::GetAggPubkeyFromHeight(int height) const
+CPubKey CAggregatePubkeyIndex::GetFromHeight(int height) const
 {
-    if(height == 0 || aggregatePubkeyHeight.size() == 1)
-        return aggregatePubkeyHeight.at(0).aggpubkey; 
+    if (vList.empty())
+        return CPubKey();
 
-    if(height < 0 || height > aggregatePubkeyHeight.back().height)
-        return aggregatePubkeyHeight.back().aggpubkey;
+    if (height < 0)
+        return vList.back().aggpubkey;
 
-    for(unsigned int i = 0; i < aggregatePubkeyHeight.size(); i++) {
-        if(height == aggregatePubkeyHeight.at(i).height || (aggregatePubkeyHeight.at(i).height < height && height < aggregatePubkeyHeight.at(i+1).height))
-            return aggregatePubkeyHeight.at(i).aggpubkey;
-    }
+    // first entry whose height is above the requested one; the key in effect is the one before it
+    auto it = std::upper_bound(vList.begin(), vList.end(), height, [](int h, const aggPubkeyAndHeight& c) { return h < c.height; });
+    if (it == vList.begin())
+        return vList.front().aggpubkey;
+    return std::prev(it)->aggpubkey;
+}
+
+int CAggregatePubkeyIndex::GetHeight(const CPubKey& aggpubkey) const
+{
+    auto it = mapHeight.find(aggpubkey);
+    return it == mapHeight.end() ? -1 : it->second;
 }
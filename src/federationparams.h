@@ -8,8 +8,10 @@
 
 #include <memory>
 #include <string>
+#include <unordered_map>
 #include <vector>
 #include <map>
+#include <crypto/common.h>
 #include <protocol.h>
 #include <streams.h>
 #include <pubkey.h>
@@ -28,6 +30,38 @@ struct aggPubkeyAndHeight {
     int height;
 };
 
+/**
+ * Immutable snapshot of the aggregate public keys of the federation and the
+ * heights from which each of them signs blocks. A new snapshot with a higher
+ * version is published whenever a block changing the federation is connected
+ * or disconnected, so a snapshot can be read without holding any lock.
+ */
+class CAggregatePubkeyIndex
+{
+public:
+    CAggregatePubkeyIndex() : nVersion(0) {}
+    CAggregatePubkeyIndex(std::vector<aggPubkeyAndHeight> listIn, uint64_t nVersionIn);
+
+    const std::vector<aggPubkeyAndHeight>& GetList() const { return vList; }
+    uint64_t GetVersion() const { return nVersion; }
+    /** Return the latest aggregate public key, or an invalid key if there is none */
+    CPubKey GetLatest() const;
+    /** Binary search for the key in effect at height. A negative height means the latest key */
+    CPubKey GetFromHeight(int height) const;
+    /** Return the height from which aggpubkey was first in effect, or -1 */
+    int GetHeight(const CPubKey& aggpubkey) const;
+
+private:
+    struct PubkeyHasher {
+        size_t operator()(const CPubKey& pubkey) const { return ReadLE64(pubkey.begin() + 1); }
+    };
+
+    //! Sorted by height, strictly increasing
+    std::vector<aggPubkeyAndHeight> vList;
+    std::unordered_map<CPubKey, int, PubkeyHasher> mapHeight;
+    uint64_t nVersion;
+};
+
 /**
  * CFederationParams defines the base parameters (shared between bitcoin-cli and bitcoind)
  * of a given instance of the Bitcoin system.
@@ -41,16 +75,23 @@ public:
      * Parse aggPubkey in block header.
      */
     CPubKey ReadAggregatePubkey(const std::vector<unsigned char>& pubkey, uint height) const;
-    const std::vector<aggPubkeyAndHeight>& GetAggregatePubkeyHeightList() const { return aggregatePubkeyHeight; }
-    const CPubKey& GetLatestAggregatePubkey() const { return aggregatePubkeyHeight.back().aggpubkey; }
+    /**
+     * Forget the aggregate public keys in effect from height onwards, when
+     * the block that introduced them is disconnected.
+     */
+    void RemoveAggregatePubkeysFromHeight(uint height) const;
+    /** Return the current aggregate public key snapshot */
+    std::shared_ptr<const CAggregatePubkeyIndex> GetAggregatePubkeyIndex() const { return std::atomic_load(&aggregatePubkeyIndex); }
+    std::vector<aggPubkeyAndHeight> GetAggregatePubkeyHeightList() const { return GetAggregatePubkeyIndex()->GetList(); }
+    CPubKey GetLatestAggregatePubkey() const { return GetAggregatePubkeyIndex()->GetLatest(); }
     bool ReadGenesisBlock(std::string genesisHex);
     const CBlock& GenesisBlock() const { return genesis; }
     const std::string& getDataDir() const { return dataDir; }
     const std::vector<SeedSpec6>& FixedSeeds() const { return vFixedSeeds; }
     /** Return the list of hostnames to look up for DNS seeds */
     const std::vector<std::string>& DNSSeeds() const { return vSeeds; }
-    int GetHeightFromAggregatePubkey(const CPubKey &aggpubkey) const;
-    CPubKey& GetAggPubkeyFromHeight(int height) const;
+    int GetHeightFromAggregatePubkey(const CPubKey &aggpubkey) const { return GetAggregatePubkeyIndex()->GetHeight(aggpubkey); }
+    CPubKey GetAggPubkeyFromHeight(int height) const { return GetAggregatePubkeyIndex()->GetFromHeight(height); }
 
     CFederationParams();
     CFederationParams(const int networkId, const std::string dataDirName, const std::string genesisHex);
@@ -60,7 +101,8 @@ private:
     CMessageHeader::MessageStartChars pchMessageStart;
     std::string strNetworkID;
     std::string dataDir;
-    mutable std::vector<aggPubkeyAndHeight> aggregatePubkeyHeight;
+    //! Replaced as a whole with a compare-and-swap, never modified in place
+    mutable std::shared_ptr<const CAggregatePubkeyIndex> aggregatePubkeyIndex;
     CBlock genesis;
     std::vector<std::string> vSeeds;
     std::vector<SeedSpec6> vFixedSeeds;
@@ -0,0 +1,380 @@
+// Copyright (c) 2020 Chaintope Inc.
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef TAPYRUS_FLATHASHMAP_H
+#define TAPYRUS_FLATHASHMAP_H
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iterator>
+#include <new>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+/** Implements a drop-in replacement for std::unordered_map<K, V, Hash> meant
+ *  for large maps that are looked up much more often than iterated, such as
+ *  the UTXO cache.
+ *
+ *  The table uses open addressing. Every bucket has one control byte holding
+ *  7 bits of the hash of its entry, and a group of GROUP_WIDTH control bytes
+ *  is compared against a key at once (with SSE2 where available), so a lookup
+ *  usually follows a single pointer: the one from the matching bucket to its
+ *  entry. Entries are carved out of chunks allocated from a pool and recycled
+ *  through a free list instead of being allocated one by one.
+ *
+ *  Like std::unordered_map, references to an entry stay valid until it is
+ *  erased, and an insertion may invalidate all iterators. Erasing an entry
+ *  only invalidates iterators to that entry.
+ */
+template <typename K, typename V, typename Hash>
+class flathashmap {
+public:
+    typedef K key_type;
+    typedef V mapped_type;
+    typedef std::pair<const K, V> value_type;
+    typedef size_t size_type;
+
+    static const size_t GROUP_WIDTH = 16;
+    //! The first pool chunk has room for MIN_CHUNK_NODES entries, and every
+    //! next one for twice as many as the one before, up to MAX_CHUNK_NODES.
+    static const size_t MIN_CHUNK_NODES = 16;
+    static const size_t MAX_CHUNK_NODES = 1024;
+
+private:
+    // Control bytes of buckets without an entry. Full buckets hold a value in
+    // [0, 127], so both of these are told apart by their sign bit.
+    static const int8_t CTRL_EMPTY = -128;
+    static const int8_t CTRL_DELETED = -2;
+
+    union Node {
+        Node* next; // While on the free list
+        typename std::aligned_storage<sizeof(value_type), alignof(value_type)>::type value;
+    };
+
+    static value_type* Value(Node* node) { return reinterpret_cast<value_type*>(&node->value); }
+
+    Hash hasher;
+    //! One allocation: nBuckets entry pointers, then nBuckets control bytes.
+    Node** slots = nullptr;
+    int8_t* ctrl = nullptr;
+    //! Zero, or a power of two that is at least GROUP_WIDTH.
+    size_t nBuckets = 0;
+    size_t nSize = 0;
+    //! Number of empty buckets that may still be filled before a rehash.
+    size_t nGrowthLeft = 0;
+
+    std::vector<Node*> vChunks;
+    //! Entries not yet handed out at the end of the last chunk.
+    size_t nChunkNodesLeft = 0;
+    Node* freeList = nullptr;
+
+    static int CountTrailingZeros(uint32_t mask)
+    {
+#if defined(__GNUC__)
+        return __builtin_ctz(mask);
+#else
+        int n = 0;
+        while (!(mask & 1)) {
+            mask >>= 1;
+            n++;
+        }
+        return n;
+#endif
+    }
+
+    //! Bitmask of the buckets in group whose control byte is c.
+    static uint32_t MatchByte(const int8_t* group, int8_t c)
+    {
+#if defined(__SSE2__)
+        return _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(group)), _mm_set1_epi8(c)));
+#else
+        uint32_t mask = 0;
+        for (size_t i = 0; i < GROUP_WIDTH; i++) {
+            mask |= uint32_t(group[i] == c) << i;
+        }
+        return mask;
+#endif
+    }
+
+    //! Bitmask of the buckets in group that hold no entry.
+    static uint32_t MatchEmptyOrDeleted(const int8_t* group)
+    {
+#if defined(__SSE2__)
+        return _mm_movemask_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(group)));
+#else
+        uint32_t mask = 0;
+        for (size_t i = 0; i < GROUP_WIDTH; i++) {
+            mask |= uint32_t(group[i] < 0) << i;
+        }
+        return mask;
+#endif
+    }
+
+    static int8_t HashTag(size_t hash) { return hash & 0x7f; }
+    size_t FirstGroup(size_t hash) const { return (hash >> 7) & (nBuckets / GROUP_WIDTH - 1); }
+
+    //! Bucket that holds key, or nBuckets if there is none.
+    size_t FindBucket(const K& key, size_t hash) const
+    {
+        if (nBuckets == 0) return 0;
+        const size_t groupMask = nBuckets / GROUP_WIDTH - 1;
+        const int8_t tag = HashTag(hash);
+        // Triangular probing visits every group once as the group count is
+        // a power of two, and at least one group always has an empty bucket.
+        for (size_t group = FirstGroup(hash), step = 1;; group = (group + step++) & groupMask) {
+            const int8_t* groupCtrl = ctrl + group * GROUP_WIDTH;
+            for (uint32_t match = MatchByte(groupCtrl, tag); match; match &= match - 1) {
+                const size_t pos = group * GROUP_WIDTH + CountTrailingZeros(match);
+                if (Value(slots[pos])->first == key) return pos;
+            }
+            if (MatchByte(groupCtrl, CTRL_EMPTY)) return nBuckets;
+        }
+    }
+
+    //! First bucket without an entry on the probe sequence of hash.
+    size_t FindFreeBucket(size_t hash) const
+    {
+        const size_t groupMask = nBuckets / GROUP_WIDTH - 1;
+        for (size_t group = FirstGroup(hash), step = 1;; group = (group + step++) & groupMask) {
+            const uint32_t match = MatchEmptyOrDeleted(ctrl + group * GROUP_WIDTH);
+            if (match) return group * GROUP_WIDTH + CountTrailingZeros(match);
+        }
+    }
+
+    void Rehash(size_t nNewBuckets)
+    {
+        Node** oldSlots = slots;
+        const int8_t* oldCtrl = ctrl;
+        const size_t nOldBuckets = nBuckets;
+
+        void* block = std::malloc(nNewBuckets * (sizeof(Node*) + 1));
+        if (!block) throw std::bad_alloc();
+        slots = static_cast<Node**>(block);
+        ctrl = reinterpret_cast<int8_t*>(slots + nNewBuckets);
+        std::memset(ctrl, CTRL_EMPTY, nNewBuckets);
+        nBuckets = nNewBuckets;
+        nGrowthLeft = nNewBuckets - nNewBuckets / 8 - nSize;
+
+        for (size_t i = 0; i < nOldBuckets; i++) {
+            if (oldCtrl[i] < 0) continue;
+            const size_t hash = hasher(Value(oldSlots[i])->first);
+            const size_t pos = FindFreeBucket(hash);
+            ctrl[pos] = HashTag(hash);
+            slots[pos] = oldSlots[i];
+        }
+        std::free(oldSlots);
+    }
+
+    Node* AllocateNode()
+    {
+        if (freeList) {
+            Node* node = freeList;
+            freeList = node->next;
+            return node;
+        }
+        if (nChunkNodesLeft == 0) {
+            const size_t nNodes = chunk_nodes(vChunks.size());
+            if (vChunks.size() == vChunks.capacity()) vChunks.reserve(std::max<size_t>(16, vChunks.size() * 2));
+            Node* chunk = static_cast<Node*>(std::malloc(nNodes * sizeof(Node)));
+            if (!chunk) throw std::bad_alloc();
+            vChunks.push_back(chunk);
+            nChunkNodesLeft = nNodes;
+        }
+        return vChunks.back() + (chunk_nodes(vChunks.size() - 1) - nChunkNodesLeft--);
+    }
+
+    void FreeNode(Node* node)
+    {
+        node->next = freeList;
+        freeList = node;
+    }
+
+    template <bool Const>
+    class Iterator
+    {
+        friend class flathashmap;
+        template <bool> friend class Iterator;
+
+        const flathashmap* map;
+        size_t pos;
+
+        Iterator(const flathashmap* mapIn, size_t posIn) : map(mapIn), pos(posIn) {}
+
+    public:
+        typedef std::forward_iterator_tag iterator_category;
+        typedef typename flathashmap::value_type value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef typename std::conditional<Const, const value_type*, value_type*>::type pointer;
+        typedef typename std::conditional<Const, const value_type&, value_type&>::type reference;
+
+        Iterator() : map(nullptr), pos(0) {}
+        Iterator(const Iterator<false>& it) : map(it.map), pos(it.pos) {}
+        Iterator& operator=(const Iterator&) = default;
+
+        reference operator*() const { return *Value(map->slots[pos]); }
+        pointer operator->() const { return Value(map->slots[pos]); }
+
+        Iterator& operator++()
+        {
+            while (++pos < map->nBuckets && map->ctrl[pos] < 0) {}
+            return *this;
+        }
+        Iterator operator++(int)
+        {
+            Iterator copy(*this);
+            ++*this;
+            return copy;
+        }
+
+        friend bool operator==(const Iterator& a, const Iterator& b) { return a.pos == b.pos; }
+        friend bool operator!=(const Iterator& a, const Iterator& b) { return a.pos != b.pos; }
+    };
+
+public:
+    typedef Iterator<false> iterator;
+    typedef Iterator<true> const_iterator;
+
+    flathashmap() {}
+    flathashmap(const flathashmap&) = delete;
+    flathashmap& operator=(const flathashmap&) = delete;
+    ~flathashmap() { clear(); }
+
+    iterator find(const K& key) { return iterator(this, FindBucket(key, hasher(key))); }
+    const_iterator find(const K& key) const { return const_iterator(this, FindBucket(key, hasher(key))); }
+    size_type count(const K& key) const { return find(key) != end() ? 1 : 0; }
+
+    template <typename... Args>
+    std::pair<iterator, bool> emplace(Args&&... args)
+    {
+        Node* node = AllocateNode();
+        try {
+            new (&node->value) value_type(std::forward<Args>(args)...);
+        } catch (...) {
+            FreeNode(node);
+            throw;
+        }
+        const K& key = Value(node)->first;
+        const size_t hash = hasher(key);
+        const size_t existing = FindBucket(key, hash);
+        if (existing != nBuckets) {
+            Value(node)->~value_type();
+            FreeNode(node);
+            return std::make_pair(iterator(this, existing), false);
+        }
+
+        size_t pos = nBuckets > 0 ? FindFreeBucket(hash) : 0;
+        if (nBuckets == 0 || (nGrowthLeft == 0 && ctrl[pos] == CTRL_EMPTY)) {
+            try {
+                // Only clear out the deleted buckets when that leaves
+                // enough room, and grow otherwise.
+                Rehash(nBuckets == 0 ? GROUP_WIDTH : nSize * 32 >= nBuckets * 25 ? nBuckets * 2 : nBuckets);
+            } catch (...) {
+                Value(node)->~value_type();
+                FreeNode(node);
+                throw;
+            }
+            pos = FindFreeBucket(hash);
+        }
+        if (ctrl[pos] == CTRL_EMPTY) nGrowthLeft--;
+        ctrl[pos] = HashTag(hash);
+        slots[pos] = node;
+        nSize++;
+        return std::make_pair(iterator(this, pos), true);
+    }
+
+    V& operator[](const K& key)
+    {
+        iterator it = find(key);
+        if (it == end()) {
+            it = emplace(std::piecewise_construct, std::forward_as_tuple(key), std::tuple<>()).first;
+        }
+        return it->second;
+    }
+
+    iterator erase(const_iterator it)
+    {
+        const size_t pos = it.pos;
+        Value(slots[pos])->~value_type();
+        FreeNode(slots[pos]);
+        // A lookup only moves past a group without empty buckets, so a bucket
+        // in a group that has one can become empty again.
+        if (MatchByte(ctrl + pos / GROUP_WIDTH * GROUP_WIDTH, CTRL_EMPTY)) {
+            ctrl[pos] = CTRL_EMPTY;
+            nGrowthLeft++;
+        } else {
+            ctrl[pos] = CTRL_DELETED;
+        }
+        nSize--;
+        return ++iterator(this, pos);
+    }
+    size_type erase(const K& key)
+    {
+        const_iterator it = find(key);
+        if (it == end()) return 0;
+        erase(it);
+        return 1;
+    }
+
+    bool empty() const { return nSize == 0; }
+    size_type size() const { return nSize; }
+
+    void clear()
+    {
+        for (size_t i = 0; i < nBuckets; i++) {
+            if (ctrl[i] >= 0) Value(slots[i])->~value_type();
+        }
+        for (Node* chunk : vChunks) {
+            std::free(chunk);
+        }
+        std::free(slots);
+        slots = nullptr;
+        ctrl = nullptr;
+        nBuckets = nSize = nGrowthLeft = 0;
+        std::vector<Node*>().swap(vChunks);
+        nChunkNodesLeft = 0;
+        freeList = nullptr;
+    }
+
+    //! Exchange the contents of two maps, hash functions included. No entry
+    //! moves, so references stay valid; iterators do not.
+    void swap(flathashmap& other)
+    {
+        using std::swap;
+        swap(hasher, other.hasher);
+        swap(slots, other.slots);
+        swap(ctrl, other.ctrl);
+        swap(nBuckets, other.nBuckets);
+        swap(nSize, other.nSize);
+        swap(nGrowthLeft, other.nGrowthLeft);
+        vChunks.swap(other.vChunks);
+        swap(nChunkNodesLeft, other.nChunkNodesLeft);
+        swap(freeList, other.freeList);
+    }
+
+    iterator begin() { return ++iterator(this, size_t(-1)); }
+    iterator end() { return iterator(this, nBuckets); }
+    const_iterator begin() const { return ++const_iterator(this, size_t(-1)); }
+    const_iterator end() const { return const_iterator(this, nBuckets); }
+
+    //! Accessors for memusage::DynamicUsage.
+    size_t bucket_count() const { return nBuckets; }
+    size_t chunk_count() const { return vChunks.size(); }
+    size_t chunk_list_capacity() const { return vChunks.capacity(); }
+    static size_t chunk_nodes(size_t i)
+    {
+        const size_t nNodes = MIN_CHUNK_NODES << std::min<size_t>(i, 16);
+        return nNodes < MAX_CHUNK_NODES ? nNodes : MAX_CHUNK_NODES;
+    }
+    static size_t node_size() { return sizeof(Node); }
+};
+
+#endif // TAPYRUS_FLATHASHMAP_H
@@ -146,6 +146,42 @@ public:
     }
 };
 
+/**
+ * A writer stream (for serialization) that computes two 256-bit hashes of
+ * one serialization. Data written to this stream goes into both hashes;
+ * data written to First() only goes into the first one.
+ */
+class CDualHashWriter
+{
+private:
+    CHashWriter first;
+    CHashWriter second;
+
+public:
+    CDualHashWriter(int nTypeIn, int nVersionIn) : first(nTypeIn, nVersionIn), second(nTypeIn, nVersionIn) {}
+
+    int GetType() const { return first.GetType(); }
+    int GetVersion() const { return first.GetVersion(); }
+
+    void write(const char *pch, size_t size) {
+        first.write(pch, size);
+        second.write(pch, size);
+    }
+
+    CHashWriter& First() { return first; }
+
+    // invalidate the object
+    uint256 GetFirstHash() { return first.GetHash(); }
+    uint256 GetSecondHash() { return second.GetHash(); }
+
+    template<typename T>
+    CDualHashWriter& operator<<(const T& obj) {
+        // Serialize to this stream
+        ::Serialize(*this, obj);
+        return (*this);
+    }
+};
+
 /** Reads data from an underlying stream, while hashing the read data. */
 template<typename Source>
 class CHashVerifier : public CHashWriter
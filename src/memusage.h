@@ -5,8 +5,11 @@
 #ifndef BITCOIN_MEMUSAGE_H
 #define BITCOIN_MEMUSAGE_H
 
+#include <flathashmap.h>
 #include <indirectmap.h>
+#include <prevector.h>
 
+#include <assert.h>
 #include <stdlib.h>
 
 #include <map>
@@ -165,6 +168,23 @@ static inline size_t DynamicUsage(const std::unordered_map<X, Y, Z>& m)
     return MallocUsage(sizeof(unordered_node<std::pair<const X, Y> >)) * m.size() + MallocUsage(sizeof(void*) * m.bucket_count());
 }
 
+template<typename X, typename Y, typename Z>
+static inline size_t DynamicUsage(const flathashmap<X, Y, Z>& m)
+{
+    typedef flathashmap<X, Y, Z> map_type;
+    size_t usage = MallocUsage((sizeof(void*) + 1) * m.bucket_count()) + MallocUsage(sizeof(void*) * m.chunk_list_capacity());
+    // Chunks only differ in size until they reach the largest one.
+    for (size_t i = 0; i < m.chunk_count(); i++) {
+        const size_t nNodes = map_type::chunk_nodes(i);
+        if (nNodes == map_type::MAX_CHUNK_NODES) {
+            usage += MallocUsage(nNodes * map_type::node_size()) * (m.chunk_count() - i);
+            break;
+        }
+        usage += MallocUsage(nNodes * map_type::node_size());
+    }
+    return usage;
+}
+
 }
 
 #endif // BITCOIN_MEMUSAGE_H
@@ -69,9 +69,26 @@ uint256 CMutableTransaction::GetHashMalFix() const
     return SerializeHash(*this, SER_GETHASH, SERIALIZE_TRANSACTION_MALFIX | SERIALIZE_TRANSACTION_NO_WITNESS);
 }
 
-uint256 CTransaction::ComputeHash() const
+template <typename TxType>
+CTransaction::TxHashes CTransaction::ComputeHashes(const TxType& tx)
 {
-    return SerializeHash(*this, SER_GETHASH, SERIALIZE_TRANSACTION_NO_WITNESS);
+    // The MalFix serialization is the regular one without the scriptSigs,
+    // so only those are kept out of the second hash.
+    CDualHashWriter ss(SER_GETHASH, SERIALIZE_TRANSACTION_NO_WITNESS);
+    ss << tx.nFeatures;
+    WriteCompactSize(ss, tx.vin.size());
+    for (const CTxIn& txin : tx.vin) {
+        ss << txin.prevout;
+        ss.First() << txin.scriptSig;
+        ss << txin.nSequence;
+    }
+    ss << tx.vout;
+    ss << tx.nLockTime;
+
+    TxHashes hashes;
+    hashes.hash = ss.GetFirstHash();
+    hashes.hashMalFix = ss.GetSecondHash();
+    return hashes;
 }
 
 uint256 CTransaction::ComputeWitnessHash() const
@@ -82,11 +99,6 @@ uint256 CTransaction::ComputeWitnessHash() const
     return SerializeHash(*this, SER_GETHASH, 0);
 }
 
-uint256 CTransaction::ComputeHashMalFix() const
-{
-    return SerializeHash(*this, SER_GETHASH, SERIALIZE_TRANSACTION_MALFIX | SERIALIZE_TRANSACTION_NO_WITNESS);
-}
-
 /* For backward compatibility, the hash is initialized to 0. TODO: remove the need for this default constructor entirely. */
 CTransaction::CTransaction() :
             vin(),
@@ -98,23 +110,26 @@ CTransaction::CTransaction() :
             hashMalFix{}
     {}
 
-CTransaction::CTransaction(const CMutableTransaction& tx) :
+CTransaction::CTransaction(const CMutableTransaction& tx) : CTransaction(tx, ComputeHashes(tx)) {}
+CTransaction::CTransaction(CMutableTransaction&& tx) : CTransaction(std::move(tx), ComputeHashes(tx)) {}
+
+CTransaction::CTransaction(const CMutableTransaction& tx, const TxHashes& hashes) :
             vin(tx.vin),
             vout(tx.vout),
             nFeatures(tx.nFeatures),
             nLockTime(tx.nLockTime),
-            hash{ComputeHash()},
+            hash{hashes.hash},
             m_witness_hash{ComputeWitnessHash()},
-            hashMalFix{ComputeHashMalFix()}
+            hashMalFix{hashes.hashMalFix}
     {}
-CTransaction::CTransaction(CMutableTransaction&& tx) :
+CTransaction::CTransaction(CMutableTransaction&& tx, const TxHashes& hashes) :
             vin(std::move(tx.vin)),
             vout(std::move(tx.vout)),
             nFeatures(tx.nFeatures),
             nLockTime(tx.nLockTime),
-            hash{ComputeHash()},
+            hash{hashes.hash},
             m_witness_hash{ComputeWitnessHash()},
-            hashMalFix{ComputeHashMalFix()}
+            hashMalFix{hashes.hashMalFix}
     {}
 
 CAmount CTransaction::GetValueOut() const
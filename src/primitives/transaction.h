@@ -244,9 +244,18 @@ private:
      used in previous output in spending transaction */
     const uint256 hashMalFix;
 
-    uint256 ComputeHash() const;
+    struct TxHashes {
+        uint256 hash;
+        uint256 hashMalFix;
+    };
+
+    /** Compute the hash and hashMalFix of tx from a single serialization */
+    template <typename TxType>
+    static TxHashes ComputeHashes(const TxType& tx);
     uint256 ComputeWitnessHash() const;
-    uint256 ComputeHashMalFix() const;
+
+    CTransaction(const CMutableTransaction &tx, const TxHashes& hashes);
+    CTransaction(CMutableTransaction &&tx, const TxHashes& hashes);
 
 public:
     /** Construct a CTransaction that qualifies as IsNull() */
@@ -10,11 +10,62 @@
 #include <secp256k1_schnorr.h>
 #include <secp256k1_recovery.h>
 #include <chainparams.h>
+#include <crypto/common.h>
+
+#include <mutex>
 
 namespace
 {
 /* Global secp256k1_context object used for verification. */
 secp256k1_context* secp256k1_context_verify = nullptr;
+
+/**
+ * Cache of parsed public keys, so that keys that are verified against again
+ * and again (hot addresses, multisig and federation keys) skip the point
+ * decompression done by secp256k1_ec_pubkey_parse.
+ *
+ * It is a direct mapped table indexed by the low bytes of the x coordinate;
+ * a colliding key simply replaces the previous entry. Slots are guarded by a
+ * small set of mutexes so that script checking threads rarely contend.
+ */
+class CPubKeyParseCache
+{
+private:
+    static constexpr size_t SLOTS = 1 << 13;
+    static constexpr size_t LOCKS = 64;
+
+    struct Slot {
+        //! Serialized key; an empty slot has an invalid header byte of 0.
+        unsigned char vch[CPubKey::PUBLIC_KEY_SIZE] = {0};
+        secp256k1_pubkey parsed;
+    };
+
+    Slot slots[SLOTS];
+    std::mutex locks[LOCKS];
+
+public:
+    bool Parse(const CPubKey& pubkey, secp256k1_pubkey& parsed)
+    {
+        const size_t nSlot = ReadLE64(pubkey.data() + 1) % SLOTS;
+        Slot& slot = slots[nSlot];
+        {
+            std::lock_guard<std::mutex> lock(locks[nSlot % LOCKS]);
+            // The header byte fixes the length, so equal prefixes mean equal sizes.
+            if (memcmp(slot.vch, pubkey.data(), pubkey.size()) == 0) {
+                parsed = slot.parsed;
+                return true;
+            }
+        }
+        if (!secp256k1_ec_pubkey_parse(secp256k1_context_verify, &parsed, pubkey.data(), pubkey.size()))
+            return false;
+        std::lock_guard<std::mutex> lock(locks[nSlot % LOCKS]);
+        memcpy(slot.vch, pubkey.data(), pubkey.size());
+        slot.parsed = parsed;
+        return true;
+    }
+};
+
+CPubKeyParseCache pubkeyParseCache;
 } // namespace
 
 /** This function is taken from the libsecp256k1 distribution and implements
@@ -174,7 +225,7 @@ bool CPubKey::Verify_ECDSA(const uint256 &hash, const std::vector<unsigned char>
         return false;
     secp256k1_pubkey pubkey;
     secp256k1_ecdsa_signature sig;
-    if (!secp256k1_ec_pubkey_parse(secp256k1_context_verify, &pubkey, vch, size())) {
+    if (!pubkeyParseCache.Parse(*this, pubkey)) {
         return false;
     }
     if (!ecdsa_signature_parse_der_lax(secp256k1_context_verify, &sig, vchSig.data(), vchSig.size())) {
@@ -194,12 +245,53 @@ bool CPubKey::Verify_Schnorr(const uint256 &hash, const std::vector<unsigned cha
         return false;
 
     secp256k1_pubkey pubkey;
-    if (!secp256k1_ec_pubkey_parse(secp256k1_context_verify, &pubkey, &(*this)[0], size()))
+    if (!pubkeyParseCache.Parse(*this, pubkey))
         return false;
 
     return secp256k1_schnorr_verify(secp256k1_context_verify, &vchSig[0], hash.begin(), &pubkey);
 }
 
+bool CSchnorrBatchVerifier::Add(const CPubKey& pubkey, const uint256& hash, const std::vector<unsigned char>& vchSig) {
+    if (!pubkey.IsValid() || vchSig.size() != CPubKey::SCHNORR_SIGNATURE_SIZE) {
+        fInvalid = true;
+        return false;
+    }
+
+    Entry entry;
+    entry.pubkey = pubkey;
+    entry.hash = hash;
+    memcpy(entry.sig, vchSig.data(), CPubKey::SCHNORR_SIGNATURE_SIZE);
+    entries.push_back(std::move(entry));
+    return true;
+}
+
+bool CSchnorrBatchVerifier::Verify() const {
+    if (fInvalid)
+        return false;
+
+    const size_t n = entries.size();
+    std::vector<secp256k1_pubkey> pubkeys(n);
+    std::vector<const secp256k1_pubkey*> pubkeyPtrs(n);
+    std::vector<const unsigned char*> sigPtrs(n);
+    std::vector<const unsigned char*> hashPtrs(n);
+
+    for (size_t i = 0; i < n; i++) {
+        const Entry& entry = entries[i];
+        // Block proofs and most scripts reuse the same key; parse it only once.
+        if (i > 0 && entry.pubkey == entries[i - 1].pubkey) {
+            pubkeyPtrs[i] = pubkeyPtrs[i - 1];
+        } else {
+            if (!pubkeyParseCache.Parse(entry.pubkey, pubkeys[i]))
+                return false;
+            pubkeyPtrs[i] = &pubkeys[i];
+        }
+        sigPtrs[i] = entry.sig;
+        hashPtrs[i] = entry.hash.begin();
+    }
+
+    return secp256k1_schnorr_verify_batch(secp256k1_context_verify, sigPtrs.data(), hashPtrs.data(), pubkeyPtrs.data(), n);
+}
+
 bool CPubKey::RecoverCompact(const uint256 &hash, const std::vector<unsigned char>& vchSig) {
     if (vchSig.size() != COMPACT_SIGNATURE_SIZE)
         return false;
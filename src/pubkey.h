@@ -263,6 +263,39 @@ struct CExtPubKey {
     }
 };
 
+/**
+ * Collects Schnorr signatures so that they can be verified together with a
+ * single multi-scalar multiplication. A failed batch does not tell which
+ * signature is invalid; callers fall back to CPubKey::Verify_Schnorr for that.
+ */
+class CSchnorrBatchVerifier
+{
+private:
+    struct Entry {
+        CPubKey pubkey;
+        uint256 hash;
+        unsigned char sig[CPubKey::SCHNORR_SIGNATURE_SIZE];
+    };
+
+    std::vector<Entry> entries;
+    //! Set when a signature that can never be valid was added.
+    bool fInvalid = false;
+
+public:
+    /**
+     * Queue a signature for verification.
+     * Returns false if the signature or public key is malformed, in which
+     * case the whole batch is known to fail.
+     */
+    bool Add(const CPubKey& pubkey, const uint256& hash, const std::vector<unsigned char>& vchSig);
+
+    //! Verify all queued signatures. Returns true only if all of them are valid.
+    bool Verify() const;
+
+    size_t size() const { return entries.size(); }
+    void clear() { entries.clear(); fInvalid = false; }
+};
+
 /** Users of this module must hold an ECCVerifyHandle. The constructor and
  *  destructor of these are not allowed to run in parallel, though. */
 class ECCVerifyHandle
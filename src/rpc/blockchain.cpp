@@ -73,9 +73,9 @@ UniValue blockheaderToJSON(const CBlockIndex* blockindex)
     result.pushKV("mediantime", (int64_t)blockindex->GetMedianTimePast());
     result.pushKV("nTx", (uint64_t)blockindex->nTx);
     result.pushKV("xfieldType", (uint8_t)blockindex->xfieldType);
-    if(blockindex->xfield.size())
-        result.pushKV("xfield", HexStr(blockindex->xfield));
-    result.pushKV("proof", HexStr(blockindex->proof));
+    if(blockindex->GetXField().size())
+        result.pushKV("xfield", HexStr(blockindex->GetXField()));
+    result.pushKV("proof", HexStr(blockindex->GetProof()));
 
     if (blockindex->pprev)
         result.pushKV("previousblockhash", blockindex->pprev->GetBlockHash().GetHex());
@@ -119,8 +119,8 @@ UniValue blockToJSON(const CBlock& block, const CBlockIndex* blockindex, bool tx
     result.pushKV("time", block.GetBlockTime());
     result.pushKV("mediantime", (int64_t)blockindex->GetMedianTimePast());
     result.pushKV("xfieldType", (uint64_t)blockindex->xfieldType);
-    if(blockindex->xfield.size())
-        result.pushKV("xfield", HexStr(blockindex->xfield));
+    if(blockindex->GetXField().size())
+        result.pushKV("xfield", HexStr(blockindex->GetXField()));
     result.pushKV("proof", HexStr(block.GetBlockHeader().proof));
     result.pushKV("nTx", (uint64_t)blockindex->nTx);
 
@@ -1358,7 +1358,7 @@ static UniValue invalidateblock(const JSONRPCRequest& request)
             throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Block not found");
         }
 
-        if((pblockindex->xfieldType == 1 && pblockindex->xfield.size()  == CPubKey::COMPRESSED_PUBLIC_KEY_SIZE) || pblockindex->nHeight <= FederationParams().GetHeightFromAggregatePubkey(FederationParams().GetLatestAggregatePubkey()))
+        if((pblockindex->xfieldType == 1 && pblockindex->GetXField().size()  == CPubKey::COMPRESSED_PUBLIC_KEY_SIZE) || pblockindex->nHeight <= FederationParams().GetHeightFromAggregatePubkey(FederationParams().GetLatestAggregatePubkey()))
             throw JSONRPCError(RPC_INVALID_PARAMETER, "Federation block found");
 
         InvalidateBlock(state, pblockindex);
@@ -1400,7 +1400,7 @@ static UniValue reconsiderblock(const JSONRPCRequest& request)
             throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Block not found");
         }
 
-        if((pblockindex->xfieldType == 1 && pblockindex->xfield.size()  == CPubKey::COMPRESSED_PUBLIC_KEY_SIZE) || pblockindex->nHeight <= FederationParams().GetHeightFromAggregatePubkey(FederationParams().GetLatestAggregatePubkey()))
+        if((pblockindex->xfieldType == 1 && pblockindex->GetXField().size()  == CPubKey::COMPRESSED_PUBLIC_KEY_SIZE) || pblockindex->nHeight <= FederationParams().GetHeightFromAggregatePubkey(FederationParams().GetLatestAggregatePubkey()))
             throw JSONRPCError(RPC_INVALID_PARAMETER, "Federation block found");
 
         ResetBlockFailureFlags(pblockindex);
@@ -294,6 +294,16 @@ static UniValue RPCLockedMemoryInfo()
     return obj;
 }
 
+static UniValue RPCBlockProofCacheInfo()
+{
+    BlockProofCacheStats stats = GetBlockProofCacheStats();
+    UniValue obj(UniValue::VOBJ);
+    obj.pushKV("hits", stats.nHits);
+    obj.pushKV("misses", stats.nMisses);
+    obj.pushKV("elements", uint64_t(stats.nElems));
+    return obj;
+}
+
 #ifdef HAVE_MALLOC_INFO
 static std::string RPCMallocInfo()
 {
@@ -335,6 +345,11 @@ static UniValue getmemoryinfo(const JSONRPCRequest& request)
             "    \"locked\": xxxxxx,       (numeric) Amount of bytes that succeeded locking. If this number is smaller than total, locking pages failed at some point and key data could be swapped to disk.\n"
             "    \"chunks_used\": xxxxx,   (numeric) Number allocated chunks\n"
             "    \"chunks_free\": xxxxx,   (numeric) Number unused chunks\n"
+            "  },\n"
+            "  \"blockproofcache\": {      (json object) Information about the cache of verified block proofs\n"
+            "    \"hits\": xxxxx,          (numeric) Number of proofs found in the cache\n"
+            "    \"misses\": xxxxx,        (numeric) Number of proofs not found in the cache\n"
+            "    \"elements\": xxxxx,      (numeric) Maximum number of proofs the cache can hold\n"
             "  }\n"
             "}\n"
             "\nResult (mode \"mallocinfo\"):\n"
@@ -348,6 +363,7 @@ static UniValue getmemoryinfo(const JSONRPCRequest& request)
     if (mode == "stats") {
         UniValue obj(UniValue::VOBJ);
         obj.pushKV("locked", RPCLockedMemoryInfo());
+        obj.pushKV("blockproofcache", RPCBlockProofCacheInfo());
         return obj;
     } else if (mode == "mallocinfo") {
 #ifdef HAVE_MALLOC_INFO
@@ -844,33 +844,50 @@ UniValue SignTransaction(CMutableTransaction& mtx, const UniValue& prevTxsUnival
     // Use CTransaction for the constant parts of the
     // transaction to avoid rehashing.
     const CTransaction txConst(mtx);
-    // Sign what we can:
+    const PrecomputedTransactionData txdata(txConst);
+    // Sign what we can, spreading the inputs of large transactions over as
+    // many threads as script verification uses:
+    std::vector<CTxOut> vSpentOut(mtx.vin.size());
+    std::vector<const CTxOut*> vSpent(mtx.vin.size(), nullptr);
+    std::vector<SignatureData> vSigData(mtx.vin.size());
     for (unsigned int i = 0; i < mtx.vin.size(); i++) {
-        CTxIn& txin = mtx.vin[i];
-        const Coin& coin = view.AccessCoin(txin.prevout);
+        const Coin& coin = view.AccessCoin(mtx.vin[i].prevout);
         if (coin.IsSpent()) {
-            TxInErrorToJSON(txin, vErrors, "Input not found or already spent");
             continue;
         }
-        const CScript& prevPubKey = coin.out.scriptPubKey;
-        const CAmount& amount = coin.out.nValue;
-
-        SignatureData sigdata = DataFromTransaction(mtx, i, coin.out);
+        vSpentOut[i] = coin.out;
+        vSigData[i] = DataFromTransaction(mtx, i, coin.out);
         // Only sign SIGHASH_SINGLE if there's a corresponding output:
         if (!fHashSingle || (i < mtx.vout.size())) {
-            ProduceSignature(*keystore, MutableTransactionSignatureCreator(&mtx, i, amount, nHashType, sigScheme), prevPubKey, sigdata);
+            vSpent[i] = &vSpentOut[i];
+        }
+    }
+    ProduceSignatures(*keystore, mtx, vSpent, nHashType, sigScheme, &txdata, vSigData, std::max(nScriptCheckThreads, 1));
+
+    for (unsigned int i = 0; i < mtx.vin.size(); i++) {
+        CTxIn& txin = mtx.vin[i];
+        if (vSpentOut[i].IsNull()) {
+            TxInErrorToJSON(txin, vErrors, "Input not found or already spent");
+            continue;
         }
+        const CScript& prevPubKey = vSpentOut[i].scriptPubKey;
+        const CAmount& amount = vSpentOut[i].nValue;
+        const SignatureData& sigdata = vSigData[i];
 
         UpdateInput(txin, sigdata);
 
         // amount must be specified for valid segwit signature
         if (amount == MAX_MONEY && !txin.scriptWitness.IsNull()) {
-            throw JSONRPCError(RPC_TYPE_ERROR, strprintf("Missing amount for %s", coin.out.ToString()));
+            throw JSONRPCError(RPC_TYPE_ERROR, strprintf("Missing amount for %s", vSpentOut[i].ToString()));
         }
 
+        // A complete signature was already verified with these flags
+        if (sigdata.complete) {
+            continue;
+        }
         ScriptError serror = SCRIPT_ERR_OK;
         ColorIdentifier colorId;
-        if (!VerifyScript(txin.scriptSig, prevPubKey, &txin.scriptWitness, STANDARD_SCRIPT_VERIFY_FLAGS, TransactionSignatureChecker(&txConst, i, amount), colorId, &serror)) {
+        if (!VerifyScript(txin.scriptSig, prevPubKey, &txin.scriptWitness, STANDARD_SCRIPT_VERIFY_FLAGS, TransactionSignatureChecker(&txConst, i, amount, txdata), colorId, &serror)) {
             if (serror == SCRIPT_ERR_INVALID_STACK_OPERATION) {
                 // Unable to sign input and verification failed (possible attempt to partially sign).
                 TxInErrorToJSON(txin, vErrors, "Unable to sign input, invalid stack size (possibly missing key)");
@@ -11,6 +11,7 @@
 #include <crypto/sha256.h>
 #include <pubkey.h>
 #include <script/script.h>
+#include <streams.h>
 #include <uint256.h>
 
 typedef std::vector<unsigned char> valtype;
@@ -311,6 +312,104 @@ int FindAndDelete(CScript& script, const CScript& b)
     return nFound;
 }
 
+/** The checks and signature verification of OP_CHECKSIG(VERIFY), leaving the stack to the caller. */
+static bool EvalChecksig(const valtype& vchSig, const valtype& vchPubKey, CScript scriptCode, unsigned int flags, const BaseSignatureChecker& checker, SigVersion sigversion, ScriptError* serror, bool& fSuccess)
+{
+    // Drop the signature in pre-segwit scripts but not segwit scripts
+    if (sigversion == SigVersion::BASE) {
+        int found = FindAndDelete(scriptCode, CScript(vchSig));
+        if (found > 0 && (flags & SCRIPT_VERIFY_CONST_SCRIPTCODE))
+            return set_error(serror, SCRIPT_ERR_SIG_FINDANDDELETE);
+    }
+
+    if ( (vchSig.size() == CPubKey::COMPACT_SIGNATURE_SIZE ?
+         !CheckSchnorrSignatureEncoding(vchSig, serror) :
+         !CheckECDSASignatureEncoding(vchSig, serror))
+        || !CheckPubKeyEncoding(vchPubKey, flags, sigversion, serror)) {
+        //serror is set
+        return false;
+    }
+    fSuccess = checker.CheckSig(vchSig, vchPubKey, scriptCode, sigversion);
+
+    if (!fSuccess && (flags & SCRIPT_VERIFY_NULLFAIL) && vchSig.size())
+        return set_error(serror, SCRIPT_ERR_SIG_NULLFAIL);
+
+    return true;
+}
+
+/**
+ * Execute a script matching one of the standard templates without decoding
+ * its opcodes. The result, error, color id and stack, including the partial
+ * stack left behind on failure, are the same as the generic interpreter loop
+ * produces for these exact bytes.
+ */
+static bool EvalScriptTemplate(std::vector<valtype>& stack, const CScript& script, const ScriptTemplateMatch& match, unsigned int flags, const BaseSignatureChecker& checker, SigVersion sigversion, ColorIdentifier* colorId, ScriptError* serror)
+{
+    static const valtype vchFalse(0);
+    static const valtype vchTrue(1, 1);
+
+    if (match.colorid) {
+        // <color id> OP_COLOR, which fails with the color id still pushed
+        if (stack.size() + 1 > MAX_STACK_SIZE || !colorId || colorId->type != TokenTypes::NONE) {
+            stack.emplace_back(match.colorid, match.colorid + 33);
+            if (stack.size() > MAX_STACK_SIZE)
+                return set_error(serror, SCRIPT_ERR_STACK_SIZE);
+            return set_error(serror, !colorId ? SCRIPT_ERR_OP_COLOR_UNEXPECTED : SCRIPT_ERR_OP_COLORMULTIPLE);
+        }
+        *colorId = ColorIdentifier(match.colorid, match.colorid + 33);
+    }
+
+    if (stack.size() < 1)
+        return set_error(serror, SCRIPT_ERR_INVALID_STACK_OPERATION);
+
+    valtype vchHash(CHash160::OUTPUT_SIZE);
+    CHash160().Write(stacktop(-1).data(), stacktop(-1).size()).Finalize(vchHash.data());
+    const bool fEqual = std::equal(vchHash.begin(), vchHash.end(), match.hash);
+
+    if (match.type == ScriptTemplate::P2SH || match.type == ScriptTemplate::CP2SH) {
+        // OP_HASH160 <script hash> OP_EQUAL
+        if (stack.size() + 1 > MAX_STACK_SIZE) {
+            // Overflow after OP_HASH160 or after the hash push
+            stacktop(-1) = std::move(vchHash);
+            if (stack.size() <= MAX_STACK_SIZE)
+                stack.emplace_back(match.hash, match.hash + CHash160::OUTPUT_SIZE);
+            return set_error(serror, SCRIPT_ERR_STACK_SIZE);
+        }
+        popstack(stack);
+        stack.push_back(fEqual ? vchTrue : vchFalse);
+        return set_success(serror);
+    }
+
+    // OP_DUP OP_HASH160 <pubkey hash> OP_EQUALVERIFY
+    if (stack.size() + 2 > MAX_STACK_SIZE) {
+        // Overflow after OP_DUP or after the hash push
+        valtype vch = stacktop(-1);
+        stack.push_back(std::move(vch));
+        if (stack.size() <= MAX_STACK_SIZE) {
+            stacktop(-1) = std::move(vchHash);
+            stack.emplace_back(match.hash, match.hash + CHash160::OUTPUT_SIZE);
+        }
+        return set_error(serror, SCRIPT_ERR_STACK_SIZE);
+    }
+    if (!fEqual) {
+        stack.push_back(vchFalse);
+        return set_error(serror, SCRIPT_ERR_EQUALVERIFY);
+    }
+
+    // OP_CHECKSIG
+    if (stack.size() < 2)
+        return set_error(serror, SCRIPT_ERR_INVALID_STACK_OPERATION);
+
+    bool fSuccess = false;
+    if (!EvalChecksig(stacktop(-2), stacktop(-1), script, flags, checker, sigversion, serror, fSuccess))
+        return false;
+
+    popstack(stack);
+    popstack(stack);
+    stack.push_back(fSuccess ? vchTrue : vchFalse);
+    return set_success(serror);
+}
+
 bool EvalScript(std::vector<std::vector<unsigned char> >& stack, const CScript& script, unsigned int flags, const BaseSignatureChecker& checker, SigVersion sigversion, ColorIdentifier *colorId,  ScriptError* serror)
 {
     static const CScriptNum bnZero(0);
@@ -336,6 +435,10 @@ bool EvalScript(std::vector<std::vector<unsigned char> >& stack, const CScript&
 
     try
     {
+        const ScriptTemplateMatch match = MatchScriptTemplate(script);
+        if (match.type != ScriptTemplate::NONE)
+            return EvalScriptTemplate(stack, script, match, flags, checker, sigversion, colorId, serror);
+
         while (pc < pend)
         {
             bool fExec = !count(vfExec.begin(), vfExec.end(), false);
@@ -947,24 +1050,9 @@ bool EvalScript(std::vector<std::vector<unsigned char> >& stack, const CScript&
                     // Subset of script starting at the most recent codeseparator
                     CScript scriptCode(pbegincodehash, pend);
 
-                    // Drop the signature in pre-segwit scripts but not segwit scripts
-                    if (sigversion == SigVersion::BASE) {
-                        int found = FindAndDelete(scriptCode, CScript(vchSig));
-                        if (found > 0 && (flags & SCRIPT_VERIFY_CONST_SCRIPTCODE))
-                            return set_error(serror, SCRIPT_ERR_SIG_FINDANDDELETE);
-                    }
-
-                    if ( (vchSig.size() == CPubKey::COMPACT_SIGNATURE_SIZE ?
-                         !CheckSchnorrSignatureEncoding(vchSig, serror) :
-                         !CheckECDSASignatureEncoding(vchSig, serror))
-                        || !CheckPubKeyEncoding(vchPubKey, flags, sigversion, serror)) {
-                        //serror is set
+                    bool fSuccess = false;
+                    if (!EvalChecksig(vchSig, vchPubKey, std::move(scriptCode), flags, checker, sigversion, serror, fSuccess))
                         return false;
-                    }
-                    bool fSuccess = checker.CheckSig(vchSig, vchPubKey, scriptCode, sigversion);
-
-                    if (!fSuccess && (flags & SCRIPT_VERIFY_NULLFAIL) && vchSig.size())
-                        return set_error(serror, SCRIPT_ERR_SIG_NULLFAIL);
 
                     popstack(stack);
                     popstack(stack);
@@ -1005,8 +1093,8 @@ bool EvalScript(std::vector<std::vector<unsigned char> >& stack, const CScript&
                         //Hash message
                         CSHA256().Write(vchMessage.data(), vchMessage.size())
                             .Finalize(vchHash.data());
-                        //no hashtype in signature. call VerifySignature not CheckSig
-                        fSuccess = checker.VerifySignature(vchSig, CPubKey(vchPubKey), uint256(vchHash));
+                        //no hashtype in signature. call VerifyDataSignature not CheckSig
+                        fSuccess = checker.VerifyDataSignature(vchSig, CPubKey(vchPubKey), uint256(vchHash));
                     }
 
                     if (!fSuccess && (flags & SCRIPT_VERIFY_NULLFAIL) && vchSig.size()) {
@@ -1335,6 +1423,40 @@ uint256 GetOutputsHash(const T& txTo)
     return ss.GetHash();
 }
 
+/** Size of an input with its script blanked out: prevout, empty script and nSequence */
+static constexpr size_t BLANKED_INPUT_SIZE = 32 + 4 + 1 + 4;
+
+/** A CHashWriter resuming from a precomputed SHA256 state */
+class CMidstateHashWriter
+{
+private:
+    CSHA256 ctx;
+
+public:
+    explicit CMidstateHashWriter(const CSHA256& ctxIn) : ctx(ctxIn) {}
+
+    int GetType() const { return SER_GETHASH; }
+    int GetVersion() const { return 0; }
+
+    void write(const char *pch, size_t size) {
+        ctx.Write((const unsigned char*)pch, size);
+    }
+
+    // invalidates the object
+    uint256 GetHash() {
+        uint256 result;
+        ctx.Finalize(result.begin());
+        CSHA256().Write(result.begin(), CSHA256::OUTPUT_SIZE).Finalize(result.begin());
+        return result;
+    }
+
+    template<typename T>
+    CMidstateHashWriter& operator<<(const T& obj) {
+        ::Serialize(*this, obj);
+        return (*this);
+    }
+};
+
 } // namespace
 
 template <class T>
@@ -1347,6 +1469,30 @@ PrecomputedTransactionData::PrecomputedTransactionData(const T& txTo)
         hashOutputs = GetOutputsHash(txTo);
         ready = true;
     }
+
+    // Legacy signature hashes commit to every input and output, so all but
+    // the input being signed is serialized once here rather than per input.
+    if (txTo.vin.size() > 1) {
+        CVectorWriter inputs(SER_GETHASH, 0, baseInputs, 0);
+        for (const auto& txin : txTo.vin) {
+            inputs << txin.prevout << CScript() << txin.nSequence;
+        }
+        assert(baseInputs.size() == txTo.vin.size() * BLANKED_INPUT_SIZE);
+        CVectorWriter(SER_GETHASH, 0, baseOutputs, 0) << txTo.vout << txTo.nLockTime;
+
+        std::vector<unsigned char> prefix;
+        CVectorWriter prefixWriter(SER_GETHASH, 0, prefix, 0);
+        prefixWriter << txTo.nFeatures;
+        WriteCompactSize(prefixWriter, txTo.vin.size());
+        CSHA256 ctx;
+        ctx.Write(prefix.data(), prefix.size());
+        baseMidstates.reserve(txTo.vin.size());
+        for (size_t i = 0; i < txTo.vin.size(); i++) {
+            baseMidstates.push_back(ctx);
+            ctx.Write(&baseInputs[i * BLANKED_INPUT_SIZE], BLANKED_INPUT_SIZE);
+        }
+        baseReady = true;
+    }
 }
 
 // explicit instantiation
@@ -1417,6 +1563,19 @@ uint256 SignatureHash(const CScript& scriptCode, const T& txTo, unsigned int nIn
     // Wrapper to serialize only the necessary parts of the transaction being signed
     CTransactionSignatureSerializer<T> txTmp(txTo, scriptCode, nIn, nHashType);
 
+    if (cache && cache->baseReady && cache->baseMidstates.size() == txTo.vin.size() &&
+        !(nHashType & SIGHASH_ANYONECANPAY) && (nHashType & 0x1f) != SIGHASH_SINGLE && (nHashType & 0x1f) != SIGHASH_NONE) {
+        // Resume after the inputs before nIn and take everything following
+        // the input being signed from the precomputed serialization.
+        CMidstateHashWriter ss(cache->baseMidstates[nIn]);
+        txTmp.SerializeInput(ss, nIn);
+        const size_t nAfter = (nIn + 1) * BLANKED_INPUT_SIZE;
+        ss.write((const char*)cache->baseInputs.data() + nAfter, cache->baseInputs.size() - nAfter);
+        ss.write((const char*)cache->baseOutputs.data(), cache->baseOutputs.size());
+        ss << nHashType;
+        return ss.GetHash();
+    }
+
     // Serialize and hash
     CHashWriter ss(SER_GETHASH, 0);
     ss << txTmp << nHashType;
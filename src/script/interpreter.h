@@ -11,6 +11,7 @@
 #include <primitives/transaction.h>
 #include <consensus/consensus.h>
 #include <coloridentifier.h>
+#include <crypto/sha256.h>
 
 #include <vector>
 #include <stdint.h>
@@ -141,6 +142,17 @@ struct PrecomputedTransactionData
     uint256 hashPrevouts, hashSequence, hashOutputs;
     bool ready = false;
 
+    /**
+     * Parts of the legacy SIGHASH_ALL serialization shared by all inputs of
+     * a multi-input transaction: the hasher state after the inputs before
+     * each input, the inputs with their scripts blanked out, and the outputs
+     * followed by nLockTime.
+     */
+    std::vector<CSHA256> baseMidstates;
+    std::vector<unsigned char> baseInputs;
+    std::vector<unsigned char> baseOutputs;
+    bool baseReady = false;
+
     template <class T>
     explicit PrecomputedTransactionData(const T& tx);
 };
@@ -171,6 +183,12 @@ public:
         return false;
     }
 
+    /** Verify an OP_CHECKDATASIG signature, which signs the hash of a message rather than a transaction. */
+    virtual bool VerifyDataSignature(const std::vector<unsigned char>& vchSig, const CPubKey& vchPubKey, const uint256& messagehash) const
+    {
+        return VerifySignature(vchSig, vchPubKey, messagehash);
+    }
+
     virtual bool CheckLockTime(const CScriptNum& nLockTime) const
     {
          return false;
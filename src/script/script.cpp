@@ -214,6 +214,18 @@ bool CScript::IsPayToScriptHash() const
 
 bool CScript::IsColoredScript() const
 {
+    switch (MatchScriptTemplate(*this).type)
+    {
+    case ScriptTemplate::P2PKH:
+    case ScriptTemplate::P2SH:
+        return false;
+    case ScriptTemplate::CP2PKH:
+    case ScriptTemplate::CP2SH:
+        return true;
+    case ScriptTemplate::NONE:
+        break;
+    }
+
     const_iterator pc = begin();
     opcodetype opcode;
     while (pc < end())
@@ -242,6 +254,24 @@ bool CScript::IsColoredPayToScriptHash() const
     return false;
 }
 
+bool CScript::IsColoredPayToPubkeyHash() const
+{
+    //<COLOR identifier> OP_COLOR OP_DUP OP_HASH160 <H(pubkey)> OP_EQUALVERIFY OP_CHECKSIG
+    // <COLOR identifier> : TYPE = 1 byte and 32 byte PAYLOAD
+    return (this->size() == 60 &&
+            (*this)[0] == 0x21 &&
+            (*this)[34] == OP_COLOR &&
+            (*this)[35] == OP_DUP &&
+            (*this)[36] == OP_HASH160 &&
+            (*this)[37] == 20 &&
+            (*this)[58] == OP_EQUALVERIFY &&
+            (*this)[59] == OP_CHECKSIG &&
+
+            ((*this)[1] == TokenToUint(TokenTypes::REISSUABLE) ||
+             (*this)[1] == TokenToUint(TokenTypes::NON_REISSUABLE) ||
+             (*this)[1] == TokenToUint(TokenTypes::NFT)));
+}
+
 bool CScript::IsPayToWitnessScriptHash() const
 {
     // Extra-fast test for pay-to-witness-script-hash CScripts:
@@ -368,22 +398,44 @@ bool GetScriptOp(CScriptBase::const_iterator& pc, CScriptBase::const_iterator en
 }
 
 
+ScriptTemplateMatch MatchScriptTemplate(const CScript& script)
+{
+    ScriptTemplateMatch match{ScriptTemplate::NONE, nullptr, nullptr};
+    switch (script.size())
+    {
+    case 25:
+        if (script[0] == OP_DUP && script[1] == OP_HASH160 && script[2] == 20 && script[23] == OP_EQUALVERIFY && script[24] == OP_CHECKSIG) {
+            match.type = ScriptTemplate::P2PKH;
+            match.hash = script.data() + 3;
+        }
+        break;
+    case 23:
+        if (script.IsPayToScriptHash()) {
+            match.type = ScriptTemplate::P2SH;
+            match.hash = script.data() + 2;
+        }
+        break;
+    case 60:
+        if (script.IsColoredPayToPubkeyHash()) {
+            match.type = ScriptTemplate::CP2PKH;
+            match.colorid = script.data() + 1;
+            match.hash = script.data() + 38;
+        }
+        break;
+    case 58:
+        if (script.IsColoredPayToScriptHash()) {
+            match.type = ScriptTemplate::CP2SH;
+            match.colorid = script.data() + 1;
+            match.hash = script.data() + 37;
+        }
+        break;
+    }
+    return match;
+}
+
 bool MatchColoredPayToPubkeyHash(const CScript& script, std::vector<unsigned char>& pubkeyhash, std::vector<unsigned char>& colorid)
 {
-    //<COLOR identifier> OP_COLOR OP_DUP OP_HASH160 <H(pubkey)> OP_EQUALVERIFY OP_CHECKSIG
-    // <COLOR identifier> : TYPE = 1 byte and 32 byte PAYLOAD
-    if (script.size() == 60 &&
-         script[0] == 0x21 &&
-         script[34] == OP_COLOR &&
-         script[35] == OP_DUP &&
-         script[36] == OP_HASH160 &&
-         script[37] == 20 &&
-         script[58] == OP_EQUALVERIFY &&
-         script[59] == OP_CHECKSIG &&
-
-         (script[1] == TokenToUint(TokenTypes::REISSUABLE) ||
-          script[1] == TokenToUint(TokenTypes::NON_REISSUABLE) ||
-          script[1] == TokenToUint(TokenTypes::NFT)))
+    if (script.IsColoredPayToPubkeyHash())
     {
         pubkeyhash = std::vector<unsigned char>(script.begin() + 38, script.begin() + 58);
         colorid = std::vector<unsigned char>(script.begin() + 1, script.begin() + 34);
@@ -542,6 +542,7 @@ public:
 
     bool IsColoredScript() const;
     bool IsColoredPayToScriptHash() const;
+    bool IsColoredPayToPubkeyHash() const;
 
     /** Called by IsStandardTx and P2SH/BIP62 VerifyScript (which makes it consensus-critical). */
     bool IsPushOnly(const_iterator pc) const;
@@ -594,6 +595,27 @@ public:
 };
 
 
+/** The scriptPubKey templates that make up most outputs. They are recognised
+ *  by their fixed byte layout, so no opcode parsing is needed to classify them. */
+enum class ScriptTemplate
+{
+    NONE,
+    P2PKH,  //!< OP_DUP OP_HASH160 <pubkey hash> OP_EQUALVERIFY OP_CHECKSIG
+    P2SH,   //!< OP_HASH160 <script hash> OP_EQUAL
+    CP2PKH, //!< <color id> OP_COLOR followed by P2PKH
+    CP2SH,  //!< <color id> OP_COLOR followed by P2SH
+};
+
+/** The template of a script and where its fields start inside the script. */
+struct ScriptTemplateMatch
+{
+    ScriptTemplate type;
+    const unsigned char* colorid; //!< 33 byte color id, nullptr unless the template is colored
+    const unsigned char* hash;    //!< 20 byte pubkey or script hash, nullptr for NONE
+};
+
+ScriptTemplateMatch MatchScriptTemplate(const CScript& script);
+
 bool MatchColoredPayToPubkeyHash(const CScript& script, std::vector<unsigned char>& pubkeyhash, std::vector<unsigned char>& colorid);
 
 bool MatchCustomColoredScript(const CScript& script, std::vector<unsigned char>& colorid);
@@ -12,7 +12,6 @@
 #include <util.h>
 
 #include <cuckoocache.h>
-#include <boost/thread.hpp>
 
 namespace {
 /**
@@ -25,32 +24,43 @@ class CSignatureCache
 private:
      //! Entries are SHA256(nonce || signature hash || public key || signature):
     uint256 nonce;
-    typedef CuckooCache::cache<uint256, SignatureCacheHasher> map_type;
+     //! OP_CHECKDATASIG entries are salted with their own nonce, over the message hash instead:
+    uint256 nonceData;
+    typedef CuckooCache::sharded_cache<uint256, SignatureCacheHasher> map_type;
     map_type setValid;
-    boost::shared_mutex cs_sigcache;
+
+    static void ComputeSaltedEntry(uint256& entry, const uint256& salt, const uint256 &hash, const std::vector<unsigned char>& vchSig, const CPubKey& pubkey)
+    {
+        CSHA256().Write(salt.begin(), 32).Write(hash.begin(), 32).Write(&pubkey[0], pubkey.size()).Write(vchSig.data(), vchSig.size()).Finalize(entry.begin());
+    }
 
 public:
     CSignatureCache()
     {
         GetRandBytes(nonce.begin(), 32);
+        GetRandBytes(nonceData.begin(), 32);
     }
 
     void
     ComputeEntry(uint256& entry, const uint256 &hash, const std::vector<unsigned char>& vchSig, const CPubKey& pubkey)
     {
-        CSHA256().Write(nonce.begin(), 32).Write(hash.begin(), 32).Write(&pubkey[0], pubkey.size()).Write(&vchSig[0], vchSig.size()).Finalize(entry.begin());
+        ComputeSaltedEntry(entry, nonce, hash, vchSig, pubkey);
+    }
+
+    void
+    ComputeDataEntry(uint256& entry, const uint256 &messagehash, const std::vector<unsigned char>& vchSig, const CPubKey& pubkey)
+    {
+        ComputeSaltedEntry(entry, nonceData, messagehash, vchSig, pubkey);
     }
 
     bool
     Get(const uint256& entry, const bool erase)
     {
-        boost::shared_lock<boost::shared_mutex> lock(cs_sigcache);
         return setValid.contains(entry, erase);
     }
 
-    void Set(uint256& entry)
+    void Set(const uint256& entry)
     {
-        boost::unique_lock<boost::shared_mutex> lock(cs_sigcache);
         setValid.insert(entry);
     }
     uint32_t setup_bytes(size_t n)
@@ -73,22 +83,57 @@ static CSignatureCache signatureCache;
 void InitSignatureCache()
 {
     // nMaxCacheSize is unsigned. If -maxsigcachesize is set to zero,
-    // setup_bytes creates the minimum possible cache (2 elements).
+    // setup_bytes creates the minimum possible cache (2 elements per shard).
     size_t nMaxCacheSize = std::min(std::max((int64_t)0, gArgs.GetArg("-maxsigcachesize", DEFAULT_MAX_SIG_CACHE_SIZE) / 2), MAX_MAX_SIG_CACHE_SIZE) * ((size_t) 1 << 20);
     size_t nElems = signatureCache.setup_bytes(nMaxCacheSize);
     LogPrintf("Using %zu MiB out of %zu/2 requested for signature cache, able to store %zu elements\n",
             (nElems*sizeof(uint256)) >>20, (nMaxCacheSize*2)>>20, nElems);
 }
 
+bool CachingTransactionSignatureChecker::VerifyCachedSignature(const uint256& entry, const std::vector<unsigned char>& vchSig, const CPubKey& pubkey, const uint256& hash) const
+{
+    if (signatureCache.Get(entry, !store))
+        return true;
+    if (!TransactionSignatureChecker::VerifySignature(vchSig, pubkey, hash))
+        return false;
+    if (store)
+        signatureCache.Set(entry);
+    return true;
+}
+
 bool CachingTransactionSignatureChecker::VerifySignature(const std::vector<unsigned char>& vchSig, const CPubKey& pubkey, const uint256& sighash) const
 {
     uint256 entry;
     signatureCache.ComputeEntry(entry, sighash, vchSig, pubkey);
+    return VerifyCachedSignature(entry, vchSig, pubkey, sighash);
+}
+
+bool CachingTransactionSignatureChecker::VerifyDataSignature(const std::vector<unsigned char>& vchSig, const CPubKey& pubkey, const uint256& messagehash) const
+{
+    uint256 entry;
+    signatureCache.ComputeDataEntry(entry, messagehash, vchSig, pubkey);
+    return VerifyCachedSignature(entry, vchSig, pubkey, messagehash);
+}
+
+bool DeferringTransactionSignatureChecker::VerifyCachedSignature(const uint256& entry, const std::vector<unsigned char>& vchSig, const CPubKey& pubkey, const uint256& hash) const
+{
+    if (vchSig.size() != CPubKey::SCHNORR_SIGNATURE_SIZE)
+        return CachingTransactionSignatureChecker::VerifyCachedSignature(entry, vchSig, pubkey, hash);
+
     if (signatureCache.Get(entry, !store))
         return true;
-    if (!TransactionSignatureChecker::VerifySignature(vchSig, pubkey, sighash))
+    // A malformed key never verifies; keep it out of the batch so the rest
+    // of the batch stays usable.
+    if (!pubkey.IsValid())
         return false;
+    batch.Add(pubkey, hash, vchSig);
     if (store)
-        signatureCache.Set(entry);
+        vCacheEntries.push_back(entry);
     return true;
 }
+
+void StoreDeferredSignatureCacheEntries(const std::vector<uint256>& vCacheEntries)
+{
+    for (uint256 entry : vCacheEntries)
+        signatureCache.Set(entry);
+}
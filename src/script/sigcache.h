@@ -18,6 +18,7 @@ static const unsigned int DEFAULT_MAX_SIG_CACHE_SIZE = 32;
 static const int64_t MAX_MAX_SIG_CACHE_SIZE = 16384;
 
 class CPubKey;
+class CSchnorrBatchVerifier;
 
 /**
  * We're hashing a nonce into the entries themselves, so we don't need extra
@@ -40,17 +41,51 @@ public:
     }
 };
 
+/**
+ * Signature checker that looks signatures up in the signature cache before
+ * verifying them. Transaction signatures and OP_CHECKDATASIG signatures are
+ * cached under separately salted entries, so that one can never stand in for
+ * the other even when the signed hashes are equal.
+ */
 class CachingTransactionSignatureChecker : public TransactionSignatureChecker
 {
-private:
+protected:
     bool store;
 
+    /** Return whether the signature is valid, consulting the cache under the given entry first. */
+    virtual bool VerifyCachedSignature(const uint256& entry, const std::vector<unsigned char>& vchSig, const CPubKey& vchPubKey, const uint256& hash) const;
+
 public:
     CachingTransactionSignatureChecker(const CTransaction* txToIn, unsigned int nInIn, const CAmount& amountIn, bool storeIn, PrecomputedTransactionData& txdataIn) : TransactionSignatureChecker(txToIn, nInIn, amountIn, txdataIn), store(storeIn) {}
 
     bool VerifySignature(const std::vector<unsigned char>& vchSig, const CPubKey& vchPubKey, const uint256& sighash) const override;
+    bool VerifyDataSignature(const std::vector<unsigned char>& vchSig, const CPubKey& vchPubKey, const uint256& messagehash) const override;
+};
+
+/**
+ * Signature checker that queues uncached Schnorr signatures into a batch
+ * instead of verifying them, and reports them as valid. The result of a
+ * script run with it only holds if the batch verifies afterwards; callers
+ * must re-run the script with a CachingTransactionSignatureChecker otherwise.
+ * ECDSA signatures are still verified immediately.
+ */
+class DeferringTransactionSignatureChecker : public CachingTransactionSignatureChecker
+{
+private:
+    CSchnorrBatchVerifier& batch;
+    //! Signature cache entries to store once the batch is known to be valid.
+    std::vector<uint256>& vCacheEntries;
+
+protected:
+    bool VerifyCachedSignature(const uint256& entry, const std::vector<unsigned char>& vchSig, const CPubKey& vchPubKey, const uint256& hash) const override;
+
+public:
+    DeferringTransactionSignatureChecker(const CTransaction* txToIn, unsigned int nInIn, const CAmount& amountIn, bool storeIn, PrecomputedTransactionData& txdataIn, CSchnorrBatchVerifier& batchIn, std::vector<uint256>& vCacheEntriesIn) : CachingTransactionSignatureChecker(txToIn, nInIn, amountIn, storeIn, txdataIn), batch(batchIn), vCacheEntries(vCacheEntriesIn) {}
 };
 
+/** Add entries collected by DeferringTransactionSignatureChecker to the signature cache. */
+void StoreDeferredSignatureCacheEntries(const std::vector<uint256>& vCacheEntries);
+
 void InitSignatureCache();
 
 #endif // BITCOIN_SCRIPT_SIGCACHE_H
@@ -12,9 +12,13 @@
 #include <script/standard.h>
 #include <uint256.h>
 
+#include <atomic>
+#include <exception>
+#include <thread>
+
 typedef std::vector<unsigned char> valtype;
 
-MutableTransactionSignatureCreator::MutableTransactionSignatureCreator(const CMutableTransaction* txToIn, unsigned int nInIn, const CAmount& amountIn, int nHashTypeIn, SignatureScheme sigSchemeIn) : txTo(txToIn), nIn(nInIn), nHashType(nHashTypeIn), amount(amountIn), checker(txTo, nIn, amountIn), sigScheme(sigSchemeIn) {}
+MutableTransactionSignatureCreator::MutableTransactionSignatureCreator(const CMutableTransaction* txToIn, unsigned int nInIn, const CAmount& amountIn, int nHashTypeIn, SignatureScheme sigSchemeIn, const PrecomputedTransactionData* txdataIn) : txTo(txToIn), nIn(nInIn), nHashType(nHashTypeIn), amount(amountIn), checker(txdataIn ? MutableTransactionSignatureChecker(txTo, nIn, amountIn, *txdataIn) : MutableTransactionSignatureChecker(txTo, nIn, amountIn)), sigScheme(sigSchemeIn), txdata(txdataIn) {}
 
 bool MutableTransactionSignatureCreator::CreateSig(const SigningProvider& provider, std::vector<unsigned char>& vchSig, const CKeyID& address, const CScript& scriptCode, SigVersion sigversion) const
 {
@@ -26,7 +30,7 @@ bool MutableTransactionSignatureCreator::CreateSig(const SigningProvider& provid
     if (sigversion == SigVersion::WITNESS_V0 && !key.IsCompressed())
         return false;
 
-    uint256 hash = SignatureHash(scriptCode, *txTo, nIn, nHashType, amount, sigversion);
+    uint256 hash = SignatureHash(scriptCode, *txTo, nIn, nHashType, amount, sigversion, txdata);
 
     if(this->sigScheme == SignatureScheme::ECDSA)
     {
@@ -252,6 +256,53 @@ bool ProduceSignature(const SigningProvider& provider, const BaseSignatureCreato
     return sigdata.complete;
 }
 
+void ProduceSignatures(const SigningProvider& provider, const CMutableTransaction& txTo, const std::vector<const CTxOut*>& vSpent, int nHashType, SignatureScheme sigScheme, const PrecomputedTransactionData* txdata, std::vector<SignatureData>& vSigData, int nThreads)
+{
+    assert(vSpent.size() == txTo.vin.size() && vSigData.size() == txTo.vin.size());
+
+    // Every thread takes the next unsigned input, so that inputs which take
+    // longer to sign (e.g. multisig) do not hold up the others. All threads
+    // share the global signing context and its precomputed tables, which
+    // libsecp256k1 only reads while signing.
+    std::atomic<size_t> nNext(0);
+    auto sign_inputs = [&]() {
+        for (size_t i = nNext++; i < vSpent.size(); i = nNext++) {
+            if (vSpent[i]) {
+                ProduceSignature(provider, MutableTransactionSignatureCreator(&txTo, i, vSpent[i]->nValue, nHashType, sigScheme, txdata), vSpent[i]->scriptPubKey, vSigData[i]);
+            }
+        }
+    };
+
+    size_t nWorkers = 0;
+    if (nThreads > 1 && txTo.vin.size() >= MIN_PARALLEL_SIGNING_INPUTS) {
+        nWorkers = std::min<size_t>(nThreads, txTo.vin.size() / MIN_PARALLEL_SIGNING_INPUTS) - 1;
+    }
+
+    // Exceptions are passed on to the caller once every thread has stopped.
+    std::vector<std::exception_ptr> vErrors(nWorkers + 1);
+    std::vector<std::thread> vWorkers;
+    for (size_t w = 0; w < nWorkers; w++) {
+        vWorkers.emplace_back([&, w]() {
+            try {
+                sign_inputs();
+            } catch (...) {
+                vErrors[w] = std::current_exception();
+            }
+        });
+    }
+    try {
+        sign_inputs();
+    } catch (...) {
+        vErrors[nWorkers] = std::current_exception();
+    }
+    for (std::thread& worker : vWorkers) {
+        worker.join();
+    }
+    for (const std::exception_ptr& error : vErrors) {
+        if (error) std::rethrow_exception(error);
+    }
+}
+
 bool SignPSBTInput(const SigningProvider& provider, const CMutableTransaction& tx, PSBTInput& input, SignatureData& sigdata, int index, int sighash)
 {
     // if this input has a final scriptsig or scriptwitness, don't do anything with it
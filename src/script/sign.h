@@ -75,9 +75,11 @@ class MutableTransactionSignatureCreator : public BaseSignatureCreator {
     CAmount amount;
     const MutableTransactionSignatureChecker checker;
     SignatureScheme sigScheme;
+    const PrecomputedTransactionData* txdata;
 
 public:
-    MutableTransactionSignatureCreator(const CMutableTransaction* txToIn, unsigned int nInIn, const CAmount& amountIn, int nHashTypeIn = SIGHASH_ALL, const SignatureScheme sigScheme = SignatureScheme::ECDSA);
+    /** txdataIn, if given, must have been computed from *txToIn with its final inputs and outputs */
+    MutableTransactionSignatureCreator(const CMutableTransaction* txToIn, unsigned int nInIn, const CAmount& amountIn, int nHashTypeIn = SIGHASH_ALL, const SignatureScheme sigScheme = SignatureScheme::ECDSA, const PrecomputedTransactionData* txdataIn = nullptr);
     const BaseSignatureChecker& Checker() const override { return checker; }
     bool CreateSig(const SigningProvider& provider, std::vector<unsigned char>& vchSig, const CKeyID& keyid, const CScript& scriptCode, SigVersion sigversion) const override;
 };
@@ -684,6 +686,21 @@ struct PartiallySignedTransaction
 /** Produce a script signature using a generic signature creator. */
 bool ProduceSignature(const SigningProvider& provider, const BaseSignatureCreator& creator, const CScript& scriptPubKey, SignatureData& sigdata);
 
+/** Transactions with fewer inputs than this are signed on the calling thread only. */
+static const unsigned int MIN_PARALLEL_SIGNING_INPUTS = 16;
+
+/**
+ * Produce script signatures for the inputs of one transaction, spreading the
+ * inputs over up to nThreads threads when there are at least
+ * MIN_PARALLEL_SIGNING_INPUTS of them. vSpent[i] is the output spent by input
+ * i, or nullptr to leave that input alone. vSigData[i] holds the data already
+ * known for input i on entry and the result of ProduceSignature on return.
+ *
+ * The provider is used from all threads at once, and txTo must not change
+ * until this returns: apply the results with UpdateInput afterwards.
+ */
+void ProduceSignatures(const SigningProvider& provider, const CMutableTransaction& txTo, const std::vector<const CTxOut*>& vSpent, int nHashType, SignatureScheme sigScheme, const PrecomputedTransactionData* txdata, std::vector<SignatureData>& vSigData, int nThreads);
+
 /** Produce a script signature for a transaction. */
 bool SignSignature(const SigningProvider &provider, const CScript& fromPubKey, CMutableTransaction& txTo, unsigned int nIn, const CAmount& amount, int nHashType);
 bool SignSignature(const SigningProvider &provider, const CTransaction& txFrom, CMutableTransaction& txTo, unsigned int nIn, int nHashType);
@@ -64,15 +64,6 @@ static bool MatchPayToPubkey(const CScript& script, valtype& pubkey)
     return false;
 }
 
-static bool MatchPayToPubkeyHash(const CScript& script, valtype& pubkeyhash)
-{
-    if (script.size() == 25 && script[0] == OP_DUP && script[1] == OP_HASH160 && script[2] == 20 && script[23] == OP_EQUALVERIFY && script[24] == OP_CHECKSIG) {
-        pubkeyhash = valtype(script.begin () + 3, script.begin() + 23);
-        return true;
-    }
-    return false;
-}
-
 /** Test for "small positive integer" script opcodes - OP_1 through OP_16. */
 static constexpr bool IsSmallInteger(opcodetype opcode)
 {
@@ -156,25 +147,31 @@ bool Solver(const CScript& scriptPubKey, txnouttype& typeRet, std::vector<std::v
 {
     vSolutionsRet.clear();
 
-    // Shortcut for pay-to-script-hash, which are more constrained than the other types:
-    // it is always OP_HASH160 20 [20 byte hash] OP_EQUAL
-    if (scriptPubKey.IsPayToScriptHash())
+    // Shortcut for the standard templates, which are recognised by their fixed
+    // byte layout, e.g. pay-to-script-hash is always OP_HASH160 20 [20 byte hash] OP_EQUAL
+    const ScriptTemplateMatch match = MatchScriptTemplate(scriptPubKey);
+    switch (match.type)
     {
+    case ScriptTemplate::P2PKH:
+        typeRet = TX_PUBKEYHASH;
+        break;
+    case ScriptTemplate::P2SH:
         typeRet = TX_SCRIPTHASH;
-        std::vector<unsigned char> hashBytes(scriptPubKey.begin()+2, scriptPubKey.begin()+22);
-        vSolutionsRet.push_back(hashBytes);
-        return true;
-    }
-
-    if (scriptPubKey.IsColoredPayToScriptHash())
-    {
+        break;
+    case ScriptTemplate::CP2PKH:
+        typeRet = TX_COLOR_PUBKEYHASH;
+        break;
+    case ScriptTemplate::CP2SH:
         typeRet = TX_COLOR_SCRIPTHASH;
-        std::vector<unsigned char> hashBytes;
-        std::vector<unsigned char> colorId;
-        hashBytes.assign(scriptPubKey.begin()+37, scriptPubKey.begin()+57);
-        colorId.assign(scriptPubKey.begin()+1, scriptPubKey.begin()+34);
-        vSolutionsRet.push_back(hashBytes);
-        vSolutionsRet.push_back(colorId);
+        break;
+    case ScriptTemplate::NONE:
+        break;
+    }
+    if (match.type != ScriptTemplate::NONE) {
+        vSolutionsRet.emplace_back(match.hash, match.hash + 20);
+        if (match.colorid) {
+            vSolutionsRet.emplace_back(match.colorid, match.colorid + 33);
+        }
         return true;
     }
 
@@ -202,20 +199,6 @@ bool Solver(const CScript& scriptPubKey, txnouttype& typeRet, std::vector<std::v
         return true;
     }
 
-    if (MatchPayToPubkeyHash(scriptPubKey, data)) {
-        typeRet = TX_PUBKEYHASH;
-        vSolutionsRet.push_back(std::move(data));
-        return true;
-    }
-
-    std::vector<unsigned char> colorId;
-    if (MatchColoredPayToPubkeyHash(scriptPubKey, data, colorId)) {
-        typeRet = TX_COLOR_PUBKEYHASH;
-        vSolutionsRet.push_back(std::move(data));
-        vSolutionsRet.push_back(std::move(colorId));
-        return true;
-    }
-
     unsigned int required;
     std::vector<std::vector<unsigned char>> keys;
     if (MatchMultisig(scriptPubKey, required, keys)) {
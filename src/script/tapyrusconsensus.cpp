@@ -11,6 +11,11 @@
 #include <script/interpreter.h>
 #include <version.h>
 
+#include <algorithm>
+#include <exception>
+#include <thread>
+#include <vector>
+
 namespace {
 
 /** A class that deserializes a single CTransaction one time. */
@@ -69,6 +74,68 @@ struct ECCryptoClosure
 };
 
 ECCryptoClosure instance_of_eccryptoclosure;
+
+/**
+ * Signature checker that queues well-formed Schnorr signatures into a batch
+ * and reports them as valid. Inputs checked with it only pass if the batch
+ * verifies afterwards.
+ */
+class BatchingSignatureChecker : public TransactionSignatureChecker
+{
+private:
+    CSchnorrBatchVerifier& batch;
+
+public:
+    BatchingSignatureChecker(const CTransaction* txToIn, unsigned int nInIn, const CAmount& amountIn, const PrecomputedTransactionData& txdataIn, CSchnorrBatchVerifier& batchIn) : TransactionSignatureChecker(txToIn, nInIn, amountIn, txdataIn), batch(batchIn) {}
+
+    bool VerifySignature(const std::vector<unsigned char>& vchSig, const CPubKey& pubkey, const uint256& sighash) const override
+    {
+        if (vchSig.size() != CPubKey::SCHNORR_SIGNATURE_SIZE || !pubkey.IsValid())
+            return TransactionSignatureChecker::VerifySignature(vchSig, pubkey, sighash);
+        batch.Add(pubkey, sighash, vchSig);
+        return true;
+    }
+};
+
+/** The inputs of one transaction, with the outputs they spend. */
+struct TxVerifyJob
+{
+    const CTransaction& tx;
+    const std::vector<CTxOut>& vSpent;
+    const PrecomputedTransactionData& txdata;
+    unsigned int flags;
+    bool fBatch;
+    std::vector<int>& vErrors;
+};
+
+ScriptError verify_input(const TxVerifyJob& job, unsigned int nIn, const BaseSignatureChecker& checker)
+{
+    ScriptError serror = SCRIPT_ERR_UNKNOWN_ERROR;
+    ColorIdentifier colorId;
+    VerifyScript(job.tx.vin[nIn].scriptSig, job.vSpent[nIn].scriptPubKey, &job.tx.vin[nIn].scriptWitness, job.flags, checker, colorId, &serror);
+    return serror;
+}
+
+/** Check the inputs [nBegin, nEnd) of a job. */
+void verify_inputs(const TxVerifyJob& job, unsigned int nBegin, unsigned int nEnd)
+{
+    if (job.fBatch) {
+        CSchnorrBatchVerifier batch;
+        bool fOk = true;
+        for (unsigned int i = nBegin; i < nEnd; i++) {
+            job.vErrors[i] = verify_input(job, i, BatchingSignatureChecker(&job.tx, i, job.vSpent[i].nValue, job.txdata, batch));
+            fOk &= job.vErrors[i] == SCRIPT_ERR_OK;
+        }
+        if (fOk && batch.Verify())
+            return;
+        // The batch does not say which signature failed, and a script may
+        // have taken a branch on a deferred result: check every input again
+        // one signature at a time.
+    }
+    for (unsigned int i = nBegin; i < nEnd; i++) {
+        job.vErrors[i] = verify_input(job, i, TransactionSignatureChecker(&job.tx, i, job.vSpent[i].nValue, job.txdata));
+    }
+}
 } // namespace
 
 /** Check that all specified flags are part of the libconsensus interface. */
@@ -124,6 +191,71 @@ int bitcoinconsensus_verify_script(const unsigned char *scriptPubKey, unsigned i
     return ::verify_script(scriptPubKey, scriptPubKeyLen, am, txTo, txToLen, nIn, flags, err);
 }
 
+int bitcoinconsensus_verify_transaction(const unsigned char *txTo, unsigned int txToLen,
+                                        const bitcoinconsensus_spent_output *spentOutputs, unsigned int nSpentOutputs,
+                                        unsigned int flags, unsigned int options, unsigned int nThreads,
+                                        int *inputErrors, bitcoinconsensus_error* err)
+{
+    if (!verify_flags(flags) || (options & ~(bitcoinconsensus_VERIFY_TX_ALL)) != 0) {
+        return set_error(err, bitcoinconsensus_ERR_INVALID_FLAGS);
+    }
+    try {
+        TxInputStream stream(SER_NETWORK, PROTOCOL_VERSION, txTo, txToLen);
+        CTransaction tx(deserialize, stream);
+        if (nSpentOutputs != tx.vin.size() || (nSpentOutputs > 0 && spentOutputs == nullptr))
+            return set_error(err, bitcoinconsensus_ERR_TX_INDEX);
+        if (GetSerializeSize(tx, SER_NETWORK, PROTOCOL_VERSION) != txToLen)
+            return set_error(err, bitcoinconsensus_ERR_TX_SIZE_MISMATCH);
+
+        std::vector<CTxOut> vSpent;
+        vSpent.reserve(nSpentOutputs);
+        for (unsigned int i = 0; i < nSpentOutputs; i++) {
+            const bitcoinconsensus_spent_output& out = spentOutputs[i];
+            vSpent.emplace_back(out.amount, CScript(out.scriptPubKey, out.scriptPubKey + out.scriptPubKeyLen));
+        }
+
+        // Regardless of the verification result, the tx did not error.
+        set_error(err, bitcoinconsensus_ERR_OK);
+
+        PrecomputedTransactionData txdata(tx);
+        std::vector<int> vErrors(nSpentOutputs, SCRIPT_ERR_UNKNOWN_ERROR);
+        const TxVerifyJob job{tx, vSpent, txdata, flags, (options & bitcoinconsensus_VERIFY_TX_BATCH_SCHNORR) != 0, vErrors};
+
+        // Every thread gets one contiguous range of inputs, and with it its
+        // own batch, so a bad signature only sends that range back to the
+        // one at a time path.
+        const unsigned int nChunks = std::max(1U, std::min(nThreads, nSpentOutputs));
+        std::vector<std::thread> vThreads;
+        std::vector<std::exception_ptr> vExceptions(nChunks);
+        for (unsigned int c = 1; c < nChunks; c++) {
+            vThreads.emplace_back([&job, &vExceptions, c, nChunks, nSpentOutputs] {
+                try {
+                    verify_inputs(job, (uint64_t)nSpentOutputs * c / nChunks, (uint64_t)nSpentOutputs * (c + 1) / nChunks);
+                } catch (...) {
+                    vExceptions[c] = std::current_exception();
+                }
+            });
+        }
+        try {
+            verify_inputs(job, 0, nSpentOutputs / nChunks);
+        } catch (...) {
+            vExceptions[0] = std::current_exception();
+        }
+        for (std::thread& thread : vThreads)
+            thread.join();
+        for (const std::exception_ptr& e : vExceptions) {
+            if (e)
+                std::rethrow_exception(e);
+        }
+
+        if (inputErrors)
+            std::copy(vErrors.begin(), vErrors.end(), inputErrors);
+        return std::all_of(vErrors.begin(), vErrors.end(), [](int e) { return e == SCRIPT_ERR_OK; });
+    } catch (const std::exception&) {
+        return set_error(err, bitcoinconsensus_ERR_TX_DESERIALIZE); // Error deserializing
+    }
+}
+
 unsigned int bitcoinconsensus_version()
 {
     // Just use the API version for now
@@ -34,7 +34,7 @@
 extern "C" {
 #endif
 
-#define BITCOINCONSENSUS_API_VER 1
+#define BITCOINCONSENSUS_API_VER 2
 
 typedef enum bitcoinconsensus_error_t
 {
@@ -54,6 +54,24 @@ enum
     bitcoinconsensus_SCRIPT_FLAGS_VERIFY_ALL                 = 0
 };
 
+/** Transaction verification options */
+enum
+{
+    bitcoinconsensus_VERIFY_TX_NONE                          = 0,
+    bitcoinconsensus_VERIFY_TX_BATCH_SCHNORR                 = (1U << 0), // verify Schnorr signatures as a batch
+    bitcoinconsensus_VERIFY_TX_ALL                           = bitcoinconsensus_VERIFY_TX_BATCH_SCHNORR
+};
+
+/** An output spent by the transaction passed to bitcoinconsensus_verify_transaction.
+ *  Colored outputs are passed the same way, with the color identifier as part of
+ *  scriptPubKey. */
+typedef struct bitcoinconsensus_spent_output_t
+{
+    const unsigned char *scriptPubKey;
+    unsigned int scriptPubKeyLen;
+    int64_t amount;
+} bitcoinconsensus_spent_output;
+
 /// Returns 1 if the input nIn of the serialized transaction pointed to by
 /// txTo correctly spends the scriptPubKey pointed to by scriptPubKey under
 /// the additional constraints specified by flags.
@@ -66,6 +84,19 @@ EXPORT_SYMBOL int bitcoinconsensus_verify_script_with_amount(const unsigned char
                                     const unsigned char *txTo        , unsigned int txToLen,
                                     unsigned int nIn, unsigned int flags, bitcoinconsensus_error* err);
 
+/// Returns 1 if every input of the serialized transaction pointed to by txTo
+/// correctly spends the matching entry of spentOutputs, which must hold one
+/// output per input, under the additional constraints specified by flags.
+/// Inputs are checked on up to nThreads threads; 0 or 1 checks them on the
+/// calling thread. options is a combination of bitcoinconsensus_VERIFY_TX_*.
+/// If not nullptr, inputErrors must have room for nSpentOutputs entries and
+/// receives 0 for every valid input and the ScriptError code of every invalid one.
+/// If not nullptr, err will contain an error/success code for the operation
+EXPORT_SYMBOL int bitcoinconsensus_verify_transaction(const unsigned char *txTo, unsigned int txToLen,
+                                                      const bitcoinconsensus_spent_output *spentOutputs, unsigned int nSpentOutputs,
+                                                      unsigned int flags, unsigned int options, unsigned int nThreads,
+                                                      int *inputErrors, bitcoinconsensus_error* err);
+
 EXPORT_SYMBOL unsigned int bitcoinconsensus_version();
 
 #ifdef __cplusplus
@@ -164,6 +164,258 @@ int secp256k1_schnorr_verify(
     return 1;
 }
 
+/* Helper function to compute the seed of the batch randomizers. It commits
+ * to every (signature, message, public key) triple of the batch so that an
+ * attacker cannot choose signatures that cancel each other out. */
+static void secp256k1_schnorr_batch_seed(
+    unsigned char *seed32,
+    const unsigned char *const *sig64,
+    const unsigned char *const *msg32,
+    const secp256k1_pubkey *const *pubkeys,
+    size_t n_sigs
+) {
+    secp256k1_sha256_t sha;
+    size_t i;
+    secp256k1_sha256_initialize(&sha);
+    for (i = 0; i < n_sigs; i++) {
+        secp256k1_sha256_write(&sha, sig64[i], 64);
+        secp256k1_sha256_write(&sha, msg32[i], 32);
+        secp256k1_sha256_write(&sha, pubkeys[i]->data, sizeof(pubkeys[i]->data));
+    }
+    secp256k1_sha256_finalize(&sha, seed32);
+}
+
+/* Helper function to compute the 128-bit randomizer of the i-th entry */
+static void secp256k1_schnorr_batch_randomizer(
+    secp256k1_scalar *a,
+    const unsigned char *seed32,
+    size_t i
+) {
+    secp256k1_sha256_t sha;
+    unsigned char buf[32];
+    int j;
+
+    for (j = 0; j < 8; j++) {
+        buf[j] = (unsigned char)((uint64_t)i >> (8 * j));
+    }
+    secp256k1_sha256_initialize(&sha);
+    secp256k1_sha256_write(&sha, seed32, 32);
+    secp256k1_sha256_write(&sha, buf, 8);
+    secp256k1_sha256_finalize(&sha, buf);
+
+    /* 128 bits of randomness are enough and halve the cost of a*R. */
+    memset(buf, 0, 16);
+    secp256k1_scalar_set_b32(a, buf, NULL);
+    if (secp256k1_scalar_is_zero(a)) {
+        secp256k1_scalar_set_int(a, 1);
+    }
+}
+
+/* Strauss multi-scalar multiplication: r = sum(scs[i] * pts[i]).
+ * The odd multiples tables of all points share a single field inversion and
+ * all points share the same chain of doublings. */
+static void secp256k1_schnorr_ecmult_multi_var(
+    secp256k1_gej *r,
+    const secp256k1_ge *pts,
+    const secp256k1_scalar *scs,
+    size_t n,
+    const secp256k1_callback *cb
+) {
+    const size_t tsize = ECMULT_TABLE_SIZE(WINDOW_A);
+    secp256k1_gej *prej;
+    secp256k1_fe *zr;
+    secp256k1_fe *lastz;
+    secp256k1_fe *lastzi;
+    secp256k1_ge *pre;
+    secp256k1_ge tmpa;
+    int *wnaf;
+    int *bits;
+    int maxbits = 0;
+    int b;
+    size_t i;
+
+    secp256k1_gej_set_infinity(r);
+    if (n == 0) {
+        return;
+    }
+
+    prej = (secp256k1_gej *)checked_malloc(cb, sizeof(secp256k1_gej) * n * tsize);
+    zr = (secp256k1_fe *)checked_malloc(cb, sizeof(secp256k1_fe) * n * tsize);
+    lastz = (secp256k1_fe *)checked_malloc(cb, sizeof(secp256k1_fe) * n);
+    lastzi = (secp256k1_fe *)checked_malloc(cb, sizeof(secp256k1_fe) * n);
+    pre = (secp256k1_ge *)checked_malloc(cb, sizeof(secp256k1_ge) * n * tsize);
+    wnaf = (int *)checked_malloc(cb, sizeof(int) * n * 256);
+    bits = (int *)checked_malloc(cb, sizeof(int) * n);
+
+    for (i = 0; i < n; i++) {
+        secp256k1_gej a;
+        secp256k1_gej_set_ge(&a, &pts[i]);
+        secp256k1_ecmult_odd_multiples_table(tsize, &prej[i * tsize], &zr[i * tsize], &a);
+        lastz[i] = prej[i * tsize + tsize - 1].z;
+        bits[i] = secp256k1_ecmult_wnaf(&wnaf[i * 256], 256, &scs[i], WINDOW_A);
+        if (bits[i] > maxbits) {
+            maxbits = bits[i];
+        }
+    }
+
+    /* Convert all tables to affine coordinates with one inversion. Only the
+     * last entry of each table has a meaningful Z; the others are recovered
+     * from the z-ratios, as in secp256k1_ge_set_table_gej_var. */
+    secp256k1_fe_inv_all_var(lastzi, lastz, n);
+    for (i = 0; i < n; i++) {
+        size_t j = tsize - 1;
+        secp256k1_fe zi = lastzi[i];
+        secp256k1_ge_set_gej_zinv(&pre[i * tsize + j], &prej[i * tsize + j], &zi);
+        while (j > 0) {
+            secp256k1_fe_mul(&zi, &zi, &zr[i * tsize + j]);
+            j--;
+            secp256k1_ge_set_gej_zinv(&pre[i * tsize + j], &prej[i * tsize + j], &zi);
+        }
+    }
+
+    for (b = maxbits - 1; b >= 0; b--) {
+        int v;
+        secp256k1_gej_double_var(r, r, NULL);
+        for (i = 0; i < n; i++) {
+            if (b < bits[i] && (v = wnaf[i * 256 + b])) {
+                ECMULT_TABLE_GET_GE(&tmpa, &pre[i * tsize], v, WINDOW_A);
+                secp256k1_gej_add_ge_var(r, r, &tmpa, NULL);
+            }
+        }
+    }
+
+    free(bits);
+    free(wnaf);
+    free(pre);
+    free(lastzi);
+    free(lastz);
+    free(zr);
+    free(prej);
+}
+
+ /* Batch verification:
+ *   Inputs:
+ *     n triples (m_i, P_i, (r_i, s_i)) as in secp256k1_schnorr_verify.
+ *
+ *   Any signature is invalid if s_i >= order, r_i >= p, or r_i does not
+ *   decompress into a point R_i whose y is a quadratic residue.
+ *   Compute e_i = Hash(r_i || compressed(P_i) || m_i) mod n.
+ *   Pick a_0 = 1 and a_i (i > 0) as 128-bit randomizers derived from a hash
+ *   of the whole batch.
+ *   The batch is valid if sum(a_i * R_i) + sum(a_i * e_i * P_i)
+ *   - (sum(a_i * s_i)) * G == 0.
+ */
+int secp256k1_schnorr_verify_batch(
+    const secp256k1_context* ctx,
+    const unsigned char *const *sig64,
+    const unsigned char *const *msg32,
+    const secp256k1_pubkey *const *pubkeys,
+    size_t n_sigs
+) {
+    secp256k1_ge *pts;
+    secp256k1_scalar *scs;
+    secp256k1_scalar *prev_coeff = NULL;
+    secp256k1_scalar c0, sg;
+    secp256k1_ge p0;
+    secp256k1_gej P0j, Rj, Mj;
+    unsigned char seed[32];
+    size_t npts = 0;
+    size_t i;
+    int ret = 0;
+
+    VERIFY_CHECK(ctx != NULL);
+    ARG_CHECK(secp256k1_ecmult_context_is_built(&ctx->ecmult_ctx));
+    if (n_sigs == 0) {
+        return 1;
+    }
+    ARG_CHECK(sig64 != NULL);
+    ARG_CHECK(msg32 != NULL);
+    ARG_CHECK(pubkeys != NULL);
+    for (i = 0; i < n_sigs; i++) {
+        ARG_CHECK(sig64[i] != NULL && msg32[i] != NULL && pubkeys[i] != NULL);
+    }
+
+    pts = (secp256k1_ge *)checked_malloc(&ctx->error_callback, sizeof(secp256k1_ge) * 2 * n_sigs);
+    scs = (secp256k1_scalar *)checked_malloc(&ctx->error_callback, sizeof(secp256k1_scalar) * 2 * n_sigs);
+
+    secp256k1_schnorr_batch_seed(seed, sig64, msg32, pubkeys, n_sigs);
+    secp256k1_scalar_set_int(&sg, 0);
+
+    for (i = 0; i < n_sigs; i++) {
+        secp256k1_ge q, R;
+        secp256k1_fe Rx;
+        secp256k1_scalar a, e, s;
+        int overflow = 0;
+
+        secp256k1_pubkey_load(ctx, &q, pubkeys[i]);
+        if (secp256k1_ge_is_infinity(&q)) {
+            goto done;
+        }
+
+        /* Extract s */
+        secp256k1_scalar_set_b32(&s, sig64[i] + 32, &overflow);
+        if (overflow) {
+            goto done;
+        }
+
+        /* Extract R.x and decompress R with a quadratic residue y */
+        if (!secp256k1_fe_set_b32(&Rx, sig64[i])) {
+            goto done;
+        }
+        if (!secp256k1_ge_set_xquad(&R, &Rx)) {
+            goto done;
+        }
+
+        /* Compute e */
+        secp256k1_schnorr_compute_e(&e, sig64[i], &q, msg32[i]);
+
+        if (i == 0) {
+            secp256k1_scalar_set_int(&a, 1);
+        } else {
+            secp256k1_schnorr_batch_randomizer(&a, seed, i);
+        }
+
+        /* sg += a * s */
+        secp256k1_scalar_mul(&s, &s, &a);
+        secp256k1_scalar_add(&sg, &sg, &s);
+
+        /* a * e is the coefficient of P; merge it when P repeats. */
+        secp256k1_scalar_mul(&e, &e, &a);
+        if (i == 0) {
+            p0 = q;
+            c0 = e;
+            prev_coeff = &c0;
+        } else if (memcmp(pubkeys[i]->data, pubkeys[i - 1]->data, sizeof(pubkeys[i]->data)) == 0) {
+            secp256k1_scalar_add(prev_coeff, prev_coeff, &e);
+        } else {
+            pts[npts] = q;
+            scs[npts] = e;
+            prev_coeff = &scs[npts];
+            npts++;
+        }
+
+        pts[npts] = R;
+        scs[npts] = a;
+        npts++;
+    }
+
+    /* c0 * P_0 - sg * G, using the precomputed generator tables */
+    secp256k1_scalar_negate(&sg, &sg);
+    secp256k1_gej_set_ge(&P0j, &p0);
+    secp256k1_ecmult(&ctx->ecmult_ctx, &Rj, &P0j, &c0, &sg);
+
+    /* everything else */
+    secp256k1_schnorr_ecmult_multi_var(&Mj, pts, scs, npts, &ctx->error_callback);
+    secp256k1_gej_add_var(&Rj, &Rj, &Mj, NULL);
+
+    ret = secp256k1_gej_is_infinity(&Rj);
+
+done:
+    free(scs);
+    free(pts);
+    return ret;
+}
+
  /* Signing:
  *   Inputs:
  *     32-byte message m,
@@ -106,6 +106,55 @@ void test_schnorr_end_to_end(void) {
     CHECK(secp256k1_schnorr_verify(ctx, schnorr_signature, message, &pubkey) == 0);
 }
 
+void test_schnorr_verify_batch(void) {
+    unsigned char privkey[3][32];
+    unsigned char message[16][32];
+    unsigned char schnorr_signature[16][64];
+    secp256k1_pubkey pubkey[3];
+    const unsigned char *sigs[16];
+    const unsigned char *msgs[16];
+    const secp256k1_pubkey *pks[16];
+    int i;
+
+    for (i = 0; i < 3; i++) {
+        secp256k1_scalar key;
+        random_scalar_order_test(&key);
+        secp256k1_scalar_get_b32(privkey[i], &key);
+        CHECK(secp256k1_ec_pubkey_create(ctx, &pubkey[i], privkey[i]) == 1);
+    }
+
+    /* Runs of the same key, as in a chain of block proofs, mixed with
+     * other keys. */
+    for (i = 0; i < 16; i++) {
+        int k = (i < 10) ? 0 : (i % 3);
+        secp256k1_rand256_test(message[i]);
+        CHECK(secp256k1_schnorr_sign(ctx, schnorr_signature[i], message[i], privkey[k], NULL, NULL) == 1);
+        sigs[i] = schnorr_signature[i];
+        msgs[i] = message[i];
+        pks[i] = &pubkey[k];
+    }
+
+    CHECK(secp256k1_schnorr_verify_batch(ctx, sigs, msgs, pks, 0) == 1);
+    for (i = 1; i <= 16; i++) {
+        CHECK(secp256k1_schnorr_verify_batch(ctx, sigs, msgs, pks, i) == 1);
+    }
+
+    /* A single bad entry invalidates the batch, wherever it is. */
+    for (i = 0; i < 16; i += 5) {
+        unsigned char saved[64];
+        memcpy(saved, schnorr_signature[i], 64);
+        schnorr_signature[i][secp256k1_rand_bits(6)] += 1 + secp256k1_rand_int(255);
+        CHECK(secp256k1_schnorr_verify_batch(ctx, sigs, msgs, pks, 16) == 0);
+        memcpy(schnorr_signature[i], saved, 64);
+    }
+
+    /* A signature checked against the wrong key fails as well. */
+    pks[3] = &pubkey[1];
+    CHECK(secp256k1_schnorr_verify_batch(ctx, sigs, msgs, pks, 16) == 0);
+    pks[3] = &pubkey[0];
+    CHECK(secp256k1_schnorr_verify_batch(ctx, sigs, msgs, pks, 16) == 1);
+}
+
 void run_schnorr_compact_test(void) {
     {
         /* Test vector 1 */
@@ -671,6 +720,9 @@ void run_schnorr_tests(void) {
     for (i = 0; i < 32 * count; i++) {
         test_schnorr_end_to_end();
     }
+    for (i = 0; i < count; i++) {
+        test_schnorr_verify_batch();
+    }
 
     test_schnorr_api();
     run_schnorr_compact_test();
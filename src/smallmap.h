@@ -0,0 +1,111 @@
+// Copyright (c) 2020 Chaintope Inc.
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef TAPYRUS_SMALLMAP_H
+#define TAPYRUS_SMALLMAP_H
+
+#include <prevector.h>
+
+#include <algorithm>
+#include <functional>
+#include <stdexcept>
+#include <utility>
+
+/** Implements a drop-in replacement for std::map<K, V, Compare> meant for
+ *  maps that hold a handful of entries. The entries are kept sorted in a
+ *  prevector, so up to N of them are stored without heap allocation, lookups
+ *  are binary searches and iteration is in key order like std::map.
+ *
+ *  Unlike std::map, inserting or erasing an entry invalidates iterators and
+ *  references to the entries after it. K and V must be movable by memmove, as
+ *  required by prevector.
+ */
+template <unsigned int N, typename K, typename V, typename Compare = std::less<K>>
+class smallmap {
+public:
+    typedef K key_type;
+    typedef V mapped_type;
+    typedef std::pair<K, V> value_type;
+
+private:
+    // A size_t size keeps the inline entries 8-byte aligned behind it.
+    typedef prevector<N, value_type, size_t, ptrdiff_t> base;
+
+    struct KeyCompare {
+        bool operator()(const value_type& entry, const K& key) const { return Compare()(entry.first, key); }
+    };
+
+    alignas(value_type) base m;
+
+public:
+    typedef typename base::iterator iterator;
+    typedef typename base::const_iterator const_iterator;
+    typedef typename base::size_type size_type;
+
+    iterator lower_bound(const K& key) { return std::lower_bound(m.begin(), m.end(), key, KeyCompare()); }
+    const_iterator lower_bound(const K& key) const { return std::lower_bound(m.begin(), m.end(), key, KeyCompare()); }
+
+    iterator find(const K& key) {
+        iterator it = lower_bound(key);
+        return (it != m.end() && !Compare()(key, it->first)) ? it : m.end();
+    }
+    const_iterator find(const K& key) const {
+        const_iterator it = lower_bound(key);
+        return (it != m.end() && !Compare()(key, it->first)) ? it : m.end();
+    }
+    size_type count(const K& key) const { return find(key) != m.end() ? 1 : 0; }
+
+    std::pair<iterator, bool> insert(const value_type& value) {
+        iterator it = lower_bound(value.first);
+        if (it != m.end() && !Compare()(value.first, it->first)) {
+            return std::make_pair(it, false);
+        }
+        return std::make_pair(m.insert(it, value), true);
+    }
+    template <typename... Args>
+    std::pair<iterator, bool> emplace(Args&&... args) { return insert(value_type(std::forward<Args>(args)...)); }
+
+    V& operator[](const K& key) {
+        iterator it = lower_bound(key);
+        if (it == m.end() || Compare()(key, it->first)) {
+            it = m.insert(it, value_type(key, V()));
+        }
+        return it->second;
+    }
+    V& at(const K& key) {
+        iterator it = find(key);
+        if (it == m.end()) throw std::out_of_range("smallmap::at");
+        return it->second;
+    }
+    const V& at(const K& key) const {
+        const_iterator it = find(key);
+        if (it == m.end()) throw std::out_of_range("smallmap::at");
+        return it->second;
+    }
+
+    iterator erase(iterator pos) { return m.erase(pos); }
+    size_type erase(const K& key) {
+        iterator it = find(key);
+        if (it == m.end()) return 0;
+        m.erase(it);
+        return 1;
+    }
+
+    bool empty() const { return m.empty(); }
+    size_type size() const { return m.size(); }
+    void clear() { m.clear(); }
+    iterator begin() { return m.begin(); }
+    iterator end() { return m.end(); }
+    const_iterator begin() const { return m.begin(); }
+    const_iterator end() const { return m.end(); }
+
+    size_t allocated_memory() const { return m.allocated_memory(); }
+
+    bool operator==(const smallmap& other) const {
+        return m.size() == other.m.size() && std::equal(m.begin(), m.end(), other.m.begin());
+    }
+    bool operator!=(const smallmap& other) const { return !(*this == other); }
+};
+
+#endif // TAPYRUS_SMALLMAP_H
@@ -615,23 +615,28 @@ static void MutateTxSign(CMutableTransaction& tx, const std::string& flagStr)
     const CKeyStore& keystore = tempKeystore;
 
     bool fHashSingle = ((nHashType & ~SIGHASH_ANYONECANPAY) == SIGHASH_SINGLE);
+    const PrecomputedTransactionData txdata(mergedTx);
 
     // Sign what we can:
+    std::vector<CTxOut> vSpentOut(mergedTx.vin.size());
+    std::vector<const CTxOut*> vSpent(mergedTx.vin.size(), nullptr);
+    std::vector<SignatureData> vSigData(mergedTx.vin.size());
     for (unsigned int i = 0; i < mergedTx.vin.size(); i++) {
-        CTxIn& txin = mergedTx.vin[i];
-        const Coin& coin = view.AccessCoin(txin.prevout);
+        const Coin& coin = view.AccessCoin(mergedTx.vin[i].prevout);
         if (coin.IsSpent()) {
             continue;
         }
-        const CScript& prevPubKey = coin.out.scriptPubKey;
-        const CAmount& amount = coin.out.nValue;
-
-        SignatureData sigdata = DataFromTransaction(mergedTx, i, coin.out);
+        vSpentOut[i] = coin.out;
+        vSigData[i] = DataFromTransaction(mergedTx, i, coin.out);
         // Only sign SIGHASH_SINGLE if there's a corresponding output:
         if (!fHashSingle || (i < mergedTx.vout.size()))
-            ProduceSignature(keystore, MutableTransactionSignatureCreator(&mergedTx, i, amount, nHashType, scheme), prevPubKey, sigdata);
+            vSpent[i] = &vSpentOut[i];
+    }
+    ProduceSignatures(keystore, mergedTx, vSpent, nHashType, scheme, &txdata, vSigData, GetNumCores());
 
-        UpdateInput(txin, sigdata);
+    for (unsigned int i = 0; i < mergedTx.vin.size(); i++) {
+        if (!vSpentOut[i].IsNull())
+            UpdateInput(mergedTx.vin[i], vSigData[i]);
     }
 
     tx = mergedTx;
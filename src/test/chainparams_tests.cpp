@@ -28,6 +28,7 @@ struct ChainParamsTestingSetup {
         SetupNetworking();
         InitSignatureCache();
         InitScriptExecutionCache();
+        InitBlockProofCache();
         fCheckBlockIndex = true;
         SetDataDir("tempdir");
         writeTestGenesisBlockToFile(GetDataDir());
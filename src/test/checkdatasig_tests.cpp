@@ -6,7 +6,9 @@
 #include <test/test_tapyrus.h>
 
 #include <policy/policy.h>
+#include <pubkey.h>
 #include <script/interpreter.h>
+#include <script/sigcache.h>
 
 #include <boost/test/unit_test.hpp>
 
@@ -215,4 +217,53 @@ BOOST_AUTO_TEST_CASE(checkdatasig_test) {
     }
 }
 
+BOOST_AUTO_TEST_CASE(checkdatasig_sigcache) {
+    // A Schnorr data signature over a fresh message, as an oracle would publish
+    const valtype message = ToByteVector(InsecureRand256());
+    uint256 messageHash;
+    CSHA256().Write(message.data(), message.size()).Finalize(messageHash.begin());
+
+    KeyData kd;
+    valtype sig;
+    BOOST_CHECK(kd.privkeyC.Sign_Schnorr(messageHash, sig));
+    const CScript script = CScript() << OP_CHECKDATASIGVERIFY << OP_TRUE;
+    const stacktype stack{sig, message, ToByteVector(kd.pubkeyC)};
+
+    CMutableTransaction mtx;
+    mtx.nFeatures = 1;
+    mtx.vin.resize(1);
+    mtx.vout.resize(1);
+    const CTransaction tx(mtx);
+    PrecomputedTransactionData txdata(tx);
+
+    // Verifying through the cache, storing as mempool acceptance does and
+    // then without storing as block connection does, gives the same result.
+    for (bool store : {true, false}) {
+        CachingTransactionSignatureChecker checker(&tx, 0, 0, store, txdata);
+        stacktype s{stack};
+        ScriptError err;
+        BOOST_CHECK(EvalScript(s, script, STANDARD_SCRIPT_VERIFY_FLAGS, checker, SigVersion::BASE, nullptr, &err));
+        BOOST_CHECK_EQUAL(err, SCRIPT_ERR_OK);
+
+        valtype badsig(sig);
+        badsig[0] ^= 1;
+        s = stacktype{badsig, message, ToByteVector(kd.pubkeyC)};
+        BOOST_CHECK(!EvalScript(s, script, STANDARD_SCRIPT_VERIFY_FLAGS, checker, SigVersion::BASE, nullptr, &err));
+        BOOST_CHECK_EQUAL(err, SCRIPT_ERR_SIG_NULLFAIL);
+    }
+
+    // The stored entry is found again as a data signature, but not as a
+    // transaction signature over the same hash, which the deferring checker
+    // shows by queueing only the latter into its batch.
+    CachingTransactionSignatureChecker(&tx, 0, 0, true, txdata).VerifyDataSignature(sig, kd.pubkeyC, messageHash);
+    CSchnorrBatchVerifier batch;
+    std::vector<uint256> vCacheEntries;
+    DeferringTransactionSignatureChecker deferring(&tx, 0, 0, true, txdata, batch, vCacheEntries);
+    BOOST_CHECK(deferring.VerifyDataSignature(sig, kd.pubkeyC, messageHash));
+    BOOST_CHECK_EQUAL(batch.size(), 0U);
+    BOOST_CHECK(deferring.VerifySignature(sig, kd.pubkeyC, messageHash));
+    BOOST_CHECK_EQUAL(batch.size(), 1U);
+    BOOST_CHECK(batch.Verify());
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -3,8 +3,10 @@
 // Distributed under the MIT software license, see the accompanying
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
+#include <checkqueue.h>
 #include <coins.h>
 #include <script/standard.h>
+#include <txdb.h>
 #include <uint256.h>
 #include <undo.h>
 #include <utilstrencodings.h>
@@ -53,9 +55,9 @@ public:
 
     uint256 GetBestBlock() const override { return hashBestBlock_; }
 
-    bool BatchWrite(CCoinsMap& mapCoins, const uint256& hashBlock) override
+    bool BatchWrite(CCoinsMap& mapCoins, const uint256& hashBlock, bool erase) override
     {
-        for (CCoinsMap::iterator it = mapCoins.begin(); it != mapCoins.end(); ) {
+        for (CCoinsMap::iterator it = mapCoins.begin(); it != mapCoins.end(); it = erase ? mapCoins.erase(it) : std::next(it)) {
             if (it->second.flags & CCoinsCacheEntry::DIRTY) {
                 // Same optimization used in CCoinsViewDB is to only write dirty entries.
                 map_[it->first] = it->second.coin;
@@ -64,7 +66,6 @@ public:
                     map_.erase(it->first);
                 }
             }
-            mapCoins.erase(it++);
         }
         if (!hashBlock.IsNull())
             hashBestBlock_ = hashBlock;
@@ -870,4 +871,126 @@ BOOST_AUTO_TEST_CASE(ccoins_write)
                     CheckWriteCoins(parent_value, child_value, parent_value, parent_flags, child_flags, parent_flags);
 }
 
+BOOST_AUTO_TEST_CASE(prefetch_block_inputs)
+{
+    CCoinsViewTest base;
+    CCoinsViewCacheTest cache(&base);
+
+    // 100 coins in the backing view, and a block spending all of them, one
+    // that is missing and one of its own outputs.
+    CBlock block;
+    CMutableTransaction coinbase;
+    coinbase.vin.resize(1);
+    coinbase.vin[0].prevout.SetNull();
+    coinbase.vout.emplace_back(1, CScript() << OP_TRUE);
+    block.vtx.push_back(MakeTransactionRef(coinbase));
+    std::vector<COutPoint> vOutPoints;
+    {
+        CCoinsViewCacheTest writer(&base);
+        for (uint32_t i = 0; i < 100; i++) {
+            vOutPoints.emplace_back(InsecureRand256(), i);
+            writer.AddCoin(vOutPoints.back(), Coin(CTxOut(1000 + i, CScript() << OP_TRUE), 1, false, TokenTypes::NONE), false);
+        }
+        writer.SetBestBlock(InsecureRand256());
+        BOOST_CHECK(writer.Flush());
+    }
+    CMutableTransaction spend;
+    for (const COutPoint& outpoint : vOutPoints) {
+        spend.vin.emplace_back(outpoint);
+    }
+    spend.vin.emplace_back(COutPoint(InsecureRand256(), 0));
+    spend.vout.emplace_back(1, CScript() << OP_TRUE);
+    block.vtx.push_back(MakeTransactionRef(spend));
+    CMutableTransaction child;
+    child.vin.emplace_back(block.vtx[1]->GetHashMalFix(), 0);
+    block.vtx.push_back(MakeTransactionRef(child));
+
+    // Two coins are already in the cache, one of them spent.
+    cache.AccessCoin(vOutPoints[0]);
+    BOOST_CHECK(cache.SpendCoin(vOutPoints[1]));
+    cache.SelfTest();
+
+    BOOST_CHECK_EQUAL(PrefetchBlockInputs(block, cache, nullptr), 0U);
+
+    CCheckQueue<CCoinsPrefetchCheck> queue(1);
+    boost::thread_group tg;
+    for (int i = 0; i < 3; i++) {
+        tg.create_thread([&]{queue.Thread();});
+    }
+    BOOST_CHECK_EQUAL(PrefetchBlockInputs(block, cache, &queue), 98U);
+    tg.interrupt_all();
+    tg.join_all();
+
+    cache.SelfTest();
+    BOOST_CHECK_EQUAL(cache.GetCacheSize(), 100U);
+    BOOST_CHECK(cache.map().find(vOutPoints[1])->second.coin.IsSpent());
+    for (size_t i = 2; i < vOutPoints.size(); i++) {
+        const CCoinsCacheEntry& entry = cache.map().find(vOutPoints[i])->second;
+        BOOST_CHECK_EQUAL(entry.flags, 0);
+        BOOST_CHECK_EQUAL(entry.coin.out.nValue, CAmount(1000 + i));
+    }
+}
+
+BOOST_AUTO_TEST_CASE(flush_buffer)
+{
+    CCoinsViewDB db(1 << 20, true);
+    std::vector<COutPoint> vOutPoints;
+    {
+        CCoinsViewFlushBuffer buffer(&db);
+        CCoinsViewCacheTest cache(&buffer);
+
+        const uint256 hashBlock1 = InsecureRand256();
+        for (uint32_t i = 0; i < 20000; i++) {
+            vOutPoints.emplace_back(InsecureRand256(), i);
+            cache.AddCoin(vOutPoints.back(), Coin(CTxOut(1000 + i, CScript() << OP_TRUE), 1, false, TokenTypes::NONE), false);
+        }
+        cache.SetBestBlock(hashBlock1);
+        BOOST_CHECK(cache.Flush());
+        BOOST_CHECK_EQUAL(cache.GetCacheSize(), 0U);
+
+        // The coins are visible through the buffer while they are written.
+        BOOST_CHECK(buffer.GetBestBlock() == hashBlock1);
+        BOOST_CHECK(cache.GetBestBlock() == hashBlock1);
+        for (size_t i = 0; i < vOutPoints.size(); i++) {
+            Coin coin;
+            BOOST_CHECK(buffer.GetCoin(vOutPoints[i], coin));
+            BOOST_CHECK_EQUAL(coin.out.nValue, CAmount(1000 + i));
+        }
+
+        // The next flush waits for the first one.
+        const uint256 hashBlock2 = InsecureRand256();
+        BOOST_CHECK(cache.SpendCoin(vOutPoints[0]));
+        cache.SetBestBlock(hashBlock2);
+        BOOST_CHECK(cache.Flush());
+        BOOST_CHECK(!buffer.HaveCoin(vOutPoints[0]));
+        BOOST_CHECK(buffer.HaveCoin(vOutPoints[1]));
+        BOOST_CHECK(buffer.Sync());
+        BOOST_CHECK_EQUAL(buffer.DynamicMemoryUsage(), 0U);
+        BOOST_CHECK(db.GetBestBlock() == hashBlock2);
+        BOOST_CHECK(db.GetHeadBlocks().empty());
+        BOOST_CHECK(!db.HaveCoin(vOutPoints[0]));
+
+        // A write left pending is finished before the buffer goes away.
+        BOOST_CHECK(cache.SpendCoin(vOutPoints[1]));
+        cache.SetBestBlock(InsecureRand256());
+        BOOST_CHECK(cache.Flush());
+    }
+    BOOST_CHECK(!db.HaveCoin(vOutPoints[1]));
+    for (size_t i = 2; i < vOutPoints.size(); i++) {
+        Coin coin;
+        BOOST_CHECK(db.GetCoin(vOutPoints[i], coin));
+        BOOST_CHECK_EQUAL(coin.out.nValue, CAmount(1000 + i));
+    }
+
+    // Writing without erasing leaves the written entries in place.
+    CCoinsViewCacheTest base(&db);
+    CCoinsViewCacheTest cache(&base);
+    cache.AddCoin(COutPoint(InsecureRand256(), 0), Coin(CTxOut(1, CScript() << OP_TRUE), 1, false, TokenTypes::NONE), false);
+    BOOST_CHECK(base.BatchWrite(cache.map(), InsecureRand256(), false));
+    BOOST_CHECK_EQUAL(cache.map().size(), 1U);
+    BOOST_CHECK_EQUAL(base.map().size(), 1U);
+    BOOST_CHECK(base.map().begin()->second.coin.out == cache.map().begin()->second.coin.out);
+    base.SelfTest();
+}
+
 BOOST_AUTO_TEST_SUITE_END()
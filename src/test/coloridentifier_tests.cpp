@@ -5,6 +5,7 @@
 
 #include <test/test_tapyrus.h>
 #include <map>
+#include <unordered_set>
 #include <primitives/transaction.h>
 #include <script/script.h>
 #include <coloridentifier.h>
@@ -248,4 +249,43 @@ BOOST_AUTO_TEST_CASE(coloridentifier_map_compare)
     BOOST_CHECK_EQUAL(c5 < c4, true);
 }
 
+BOOST_AUTO_TEST_CASE(coloridentifier_parse_and_hash)
+{
+    uint256 hashMalFix(ParseHex("485273f6703f038a234400edadb543eb44b4af5372e8b207990beebc386e7954"));
+    const ColorIdentifier c1(COutPoint(hashMalFix, 0), TokenTypes::NON_REISSUABLE);
+    const ColorIdentifier c2(COutPoint(hashMalFix, 1), TokenTypes::NON_REISSUABLE);
+    const ColorIdentifier c3(COutPoint(hashMalFix, 0), TokenTypes::NFT);
+
+    //toVector matches the serialization and parses back
+    for(const ColorIdentifier& c : {c1, c2, c3, ColorIdentifier()})
+    {
+        CDataStream ss(SER_NETWORK, INIT_PROTO_VERSION);
+        ss << c;
+        const std::vector<unsigned char> vch(c.toVector());
+        BOOST_CHECK(vch == std::vector<unsigned char>(ss.begin(), ss.end()));
+        BOOST_CHECK(ColorIdentifier(vch) == c);
+        BOOST_CHECK(ColorIdentifier(vch.data(), vch.data() + vch.size()) == c);
+    }
+
+    //truncated ids are rejected like a stream would
+    std::vector<unsigned char> vch(c1.toVector());
+    vch.pop_back();
+    BOOST_CHECK_THROW(ColorIdentifier{vch}, std::ios_base::failure);
+    BOOST_CHECK_THROW(ColorIdentifier{std::vector<unsigned char>()}, std::ios_base::failure);
+
+    //the color id of the standard scripts
+    CScript cp2pkh = CScript() << c1.toVector() << OP_COLOR << OP_DUP << OP_HASH160 << std::vector<unsigned char>(20, 0x01) << OP_EQUALVERIFY << OP_CHECKSIG;
+    CScript cp2sh = CScript() << c2.toVector() << OP_COLOR << OP_HASH160 << std::vector<unsigned char>(20, 0x01) << OP_EQUAL;
+    BOOST_CHECK(GetColorIdFromScript(cp2pkh) == c1);
+    BOOST_CHECK(GetColorIdFromScript(cp2sh) == c2);
+    BOOST_CHECK(GetColorIdFromScript(CScript() << OP_TRUE) == ColorIdentifier());
+
+    //unordered containers
+    std::unordered_set<ColorIdentifier> set{c1, c2, c3};
+    BOOST_CHECK_EQUAL(set.size(), 3U);
+    BOOST_CHECK(set.count(ColorIdentifier(COutPoint(hashMalFix, 1), TokenTypes::NON_REISSUABLE)));
+    BOOST_CHECK(!set.count(ColorIdentifier(COutPoint(hashMalFix, 1), TokenTypes::NFT)));
+    BOOST_CHECK_EQUAL(std::hash<ColorIdentifier>()(c1), std::hash<ColorIdentifier>()(ColorIdentifier(c1.toVector())));
+}
+
 BOOST_AUTO_TEST_SUITE_END()
\ No newline at end of file
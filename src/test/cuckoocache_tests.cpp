@@ -378,4 +378,59 @@ BOOST_AUTO_TEST_CASE(cuckoocache_generations)
     test_cache_generations<CuckooCache::cache<uint256, SignatureCacheHasher>>();
 }
 
+typedef CuckooCache::sharded_cache<uint256, SignatureCacheHasher> sharded_cache_type;
+
+BOOST_AUTO_TEST_CASE(cuckoocache_sharded_hit_rate_ok)
+{
+    double HitRateThresh = 0.98;
+    size_t megabytes = 4;
+    for (double load = 0.1; load < 2; load *= 2) {
+        double hits = test_cache<sharded_cache_type>(megabytes, load);
+        BOOST_CHECK(normalize_hit_rate(hits, load) > HitRateThresh);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(cuckoocache_sharded_erase_ok)
+{
+    test_cache_erase<sharded_cache_type>(4);
+    test_cache_erase_parallel<sharded_cache_type>(4);
+}
+
+BOOST_AUTO_TEST_CASE(cuckoocache_sharded_generations)
+{
+    test_cache_generations<sharded_cache_type>();
+}
+
+/** Inserts and lookups from several threads at once need no external lock */
+BOOST_AUTO_TEST_CASE(cuckoocache_sharded_concurrent)
+{
+    local_rand_ctx = FastRandomContext(true);
+    sharded_cache_type set{};
+    set.setup_bytes(4 << 20);
+    // Well below capacity, so that nothing inserted is evicted
+    std::vector<uint256> hashes(40000);
+    for (uint256& h : hashes)
+        insecure_GetRandHash(h);
+
+    std::vector<std::thread> threads;
+    std::atomic<size_t> found{0};
+    for (uint32_t x = 0; x < 4; ++x) {
+        threads.emplace_back([&, x] {
+            for (size_t i = x; i < hashes.size(); i += 4) {
+                set.insert(hashes[i]);
+                // the previous element of this thread is still there
+                if (i >= 4)
+                    found += set.contains(hashes[i - 4], false);
+            }
+        });
+    }
+    for (std::thread& t : threads)
+        t.join();
+    BOOST_CHECK_EQUAL(found, hashes.size() - 4);
+    size_t count = 0;
+    for (const uint256& h : hashes)
+        count += set.contains(h, false);
+    BOOST_CHECK_EQUAL(count, hashes.size());
+}
+
 BOOST_AUTO_TEST_SUITE_END();
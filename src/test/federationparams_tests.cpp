@@ -28,6 +28,7 @@ struct FederationParamsTestingSetup {
         SetupNetworking();
         InitSignatureCache();
         InitScriptExecutionCache();
+        InitBlockProofCache();
         fCheckBlockIndex = true;
         SetDataDir("tempdir");
         writeTestGenesisBlockToFile(GetDataDir());
@@ -148,4 +149,65 @@ BOOST_AUTO_TEST_CASE(create_genesis_block_one_publickey)
     BOOST_CHECK(aggPubkey.Verify_Schnorr(blockHash, baseChainParams->GenesisBlock().proof));
 }
 
+BOOST_AUTO_TEST_CASE(aggregate_pubkey_index)
+{
+    CKey aggregateKey;
+    aggregateKey.Set(validAggPrivateKey, validAggPrivateKey + 32, true);
+    const CPubKey genesisPubkey = aggregateKey.GetPubKey();
+
+    auto params = CreateFederationParams(TAPYRUS_OP_MODE::PROD, true);
+    params->ReadGenesisBlock(getTestGenesisBlockHex(genesisPubkey, aggregateKey));
+
+    CKey key1, key2;
+    key1.MakeNewKey(true);
+    key2.MakeNewKey(true);
+    const CPubKey pubkey1 = key1.GetPubKey();
+    const CPubKey pubkey2 = key2.GetPubKey();
+
+    const uint64_t version = params->GetAggregatePubkeyIndex()->GetVersion();
+    params->ReadAggregatePubkey(std::vector<unsigned char>(pubkey1.begin(), pubkey1.end()), 10);
+    params->ReadAggregatePubkey(std::vector<unsigned char>(pubkey2.begin(), pubkey2.end()), 20);
+    BOOST_CHECK_EQUAL(params->GetAggregatePubkeyIndex()->GetVersion(), version + 2);
+    BOOST_CHECK_EQUAL(params->GetAggregatePubkeyHeightList().size(), 3);
+
+    BOOST_CHECK(params->GetAggPubkeyFromHeight(0) == genesisPubkey);
+    BOOST_CHECK(params->GetAggPubkeyFromHeight(9) == genesisPubkey);
+    BOOST_CHECK(params->GetAggPubkeyFromHeight(10) == pubkey1);
+    BOOST_CHECK(params->GetAggPubkeyFromHeight(19) == pubkey1);
+    BOOST_CHECK(params->GetAggPubkeyFromHeight(20) == pubkey2);
+    BOOST_CHECK(params->GetAggPubkeyFromHeight(1000) == pubkey2);
+    BOOST_CHECK(params->GetAggPubkeyFromHeight(-1) == pubkey2);
+    BOOST_CHECK(params->GetLatestAggregatePubkey() == pubkey2);
+
+    BOOST_CHECK_EQUAL(params->GetHeightFromAggregatePubkey(genesisPubkey), 0);
+    BOOST_CHECK_EQUAL(params->GetHeightFromAggregatePubkey(pubkey1), 10);
+    BOOST_CHECK_EQUAL(params->GetHeightFromAggregatePubkey(pubkey2), 20);
+
+    // a snapshot taken before a change is not affected by it
+    const std::shared_ptr<const CAggregatePubkeyIndex> snapshot = params->GetAggregatePubkeyIndex();
+
+    // disconnecting the block that introduced pubkey2
+    params->RemoveAggregatePubkeysFromHeight(20);
+    BOOST_CHECK(params->GetLatestAggregatePubkey() == pubkey1);
+    BOOST_CHECK(params->GetAggPubkeyFromHeight(1000) == pubkey1);
+    BOOST_CHECK_EQUAL(params->GetHeightFromAggregatePubkey(pubkey2), -1);
+    BOOST_CHECK(snapshot->GetLatest() == pubkey2);
+
+    // nothing to remove does not publish a new snapshot
+    const uint64_t versionBefore = params->GetAggregatePubkeyIndex()->GetVersion();
+    params->RemoveAggregatePubkeysFromHeight(15);
+    BOOST_CHECK_EQUAL(params->GetAggregatePubkeyIndex()->GetVersion(), versionBefore);
+
+    // a reorg to a branch that changes the federation earlier supersedes the later keys
+    params->ReadAggregatePubkey(std::vector<unsigned char>(pubkey2.begin(), pubkey2.end()), 5);
+    BOOST_CHECK_EQUAL(params->GetAggregatePubkeyHeightList().size(), 2);
+    BOOST_CHECK(params->GetAggPubkeyFromHeight(12) == pubkey2);
+    BOOST_CHECK_EQUAL(params->GetHeightFromAggregatePubkey(pubkey1), -1);
+
+    // the genesis key is never removed
+    params->RemoveAggregatePubkeysFromHeight(0);
+    BOOST_CHECK_EQUAL(params->GetAggregatePubkeyHeightList().size(), 1);
+    BOOST_CHECK(params->GetLatestAggregatePubkey() == genesisPubkey);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,166 @@
+// Copyright (c) 2020 Chaintope Inc.
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <flathashmap.h>
+
+#include <memusage.h>
+#include <test/test_tapyrus.h>
+
+#include <string>
+#include <unordered_map>
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_FIXTURE_TEST_SUITE(flathashmap_tests, BasicTestingSetup)
+
+namespace {
+
+struct MixHasher {
+    size_t operator()(uint64_t key) const { return key * 0x9E3779B97F4A7C15ULL; }
+};
+
+//! Sends every key to one of a few groups with one of a few tags, so probing
+//! past full groups and tag matches on other keys happen all the time.
+struct CollidingHasher {
+    size_t operator()(uint64_t key) const { return (key % 3) << 7 | (key % 5); }
+};
+
+template <typename Hash>
+void CheckSameContents(const flathashmap<uint64_t, std::string, Hash>& map, const std::unordered_map<uint64_t, std::string>& real)
+{
+    BOOST_CHECK_EQUAL(map.size(), real.size());
+    BOOST_CHECK_EQUAL(map.empty(), real.empty());
+    size_t count = 0;
+    for (const auto& entry : map) {
+        auto it = real.find(entry.first);
+        BOOST_CHECK(it != real.end() && it->second == entry.second);
+        count++;
+    }
+    BOOST_CHECK_EQUAL(count, real.size());
+}
+
+template <typename Hash>
+void RandomOperations(uint64_t range)
+{
+    std::unordered_map<uint64_t, std::string> real;
+    flathashmap<uint64_t, std::string, Hash> map;
+    for (int i = 0; i < 20000; i++) {
+        const uint64_t key = InsecureRandRange(range);
+        const std::string value(InsecureRandRange(40), 'a' + InsecureRandRange(26));
+        switch (InsecureRandRange(8)) {
+        case 0:
+        case 1: {
+            bool inserted = real.emplace(key, value).second;
+            auto ret = map.emplace(key, value);
+            BOOST_CHECK_EQUAL(ret.second, inserted);
+            BOOST_CHECK_EQUAL(ret.first->first, key);
+            BOOST_CHECK(ret.first->second == real[key]);
+            break;
+        }
+        case 2:
+            real[key] += value;
+            map[key] += value;
+            break;
+        case 3:
+        case 4:
+            BOOST_CHECK_EQUAL(map.erase(key), real.erase(key));
+            break;
+        case 5: {
+            auto it = map.find(key);
+            BOOST_CHECK_EQUAL(it != map.end(), real.count(key) == 1);
+            if (it != map.end()) BOOST_CHECK(it->second == real[key]);
+            BOOST_CHECK_EQUAL(map.count(key), real.count(key));
+            break;
+        }
+        case 6:
+            // Erase about half of the entries while iterating.
+            if (InsecureRandRange(100) == 0) {
+                for (auto it = map.begin(); it != map.end();) {
+                    if (InsecureRandBool()) {
+                        real.erase(it->first);
+                        it = map.erase(it);
+                    } else {
+                        ++it;
+                    }
+                }
+            }
+            break;
+        case 7:
+            if (InsecureRandRange(1000) == 0) {
+                CheckSameContents(map, real);
+                map.clear();
+                real.clear();
+            }
+            break;
+        }
+    }
+    CheckSameContents(map, real);
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_CASE(flathashmap_matches_unordered_map)
+{
+    for (uint64_t range : {8, 100, 5000}) {
+        RandomOperations<MixHasher>(range);
+        RandomOperations<CollidingHasher>(range);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(flathashmap_stable_references)
+{
+    // Entries do not move when the table grows, or when other entries are
+    // erased and their room in the pool is reused.
+    flathashmap<uint64_t, std::string, MixHasher> map;
+    std::vector<const std::string*> refs;
+    for (uint64_t i = 0; i < 1000; i++) {
+        refs.push_back(&map.emplace(i, std::to_string(i)).first->second);
+    }
+    for (uint64_t i = 0; i < 1000; i += 2) {
+        BOOST_CHECK_EQUAL(map.erase(i), 1U);
+    }
+    for (uint64_t i = 1000; i < 20000; i++) {
+        map.emplace(i, std::to_string(i));
+    }
+    for (uint64_t i = 1; i < 1000; i += 2) {
+        BOOST_CHECK_EQUAL(&map.find(i)->second, refs[i]);
+        BOOST_CHECK_EQUAL(*refs[i], std::to_string(i));
+    }
+}
+
+BOOST_AUTO_TEST_CASE(flathashmap_memusage)
+{
+    flathashmap<uint64_t, uint64_t, MixHasher> map;
+    BOOST_CHECK_EQUAL(memusage::DynamicUsage(map), 0U);
+
+    // Every chunk holds at least as many entries as all chunks before it, so
+    // no more than a chunk of entries is ever allocated ahead.
+    size_t nEntries = 0;
+    for (uint64_t i = 0; i < 100000; i++) {
+        map.emplace(i, i);
+        nEntries++;
+        size_t nPoolNodes = 0;
+        for (size_t c = 0; c < map.chunk_count(); c++) {
+            nPoolNodes += map.chunk_nodes(c);
+        }
+        BOOST_CHECK(nPoolNodes >= nEntries && nPoolNodes < 2 * nEntries + map.MAX_CHUNK_NODES);
+        BOOST_CHECK(map.bucket_count() * 7 / 8 >= nEntries);
+    }
+    const size_t usage = memusage::DynamicUsage(map);
+    BOOST_CHECK(usage >= nEntries * (map.node_size() + 9));
+
+    // Erased entries are reused rather than allocated again.
+    for (uint64_t i = 0; i < 50000; i++) {
+        map.erase(i);
+    }
+    for (uint64_t i = 100000; i < 150000; i++) {
+        map.emplace(i, i);
+    }
+    BOOST_CHECK_EQUAL(memusage::DynamicUsage(map), usage);
+
+    map.clear();
+    BOOST_CHECK_EQUAL(memusage::DynamicUsage(map), 0U);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -248,6 +248,82 @@ BOOST_AUTO_TEST_CASE(key_signature_tests)
     BOOST_CHECK(found_small);
 }
 
+BOOST_AUTO_TEST_CASE(schnorr_batch_verify_tests)
+{
+    CKey key1 = DecodeSecret(strSecret1C);
+    CKey key2 = DecodeSecret(strSecret2C);
+    CPubKey pubkey1 = key1.GetPubKey();
+    CPubKey pubkey2 = key2.GetPubKey();
+
+    std::vector<uint256> hashes;
+    std::vector<std::vector<unsigned char>> sigs;
+    CSchnorrBatchVerifier batch;
+    BOOST_CHECK(batch.Verify());
+
+    for (int i = 0; i < 20; i++) {
+        std::string msg = "A message to be signed" + std::to_string(i);
+        hashes.push_back(Hash(msg.begin(), msg.end()));
+        sigs.emplace_back();
+        const CKey& key = i % 7 == 6 ? key2 : key1;
+        BOOST_CHECK(key.Sign_Schnorr(hashes.back(), sigs.back()));
+        BOOST_CHECK(batch.Add(key.GetPubKey(), hashes.back(), sigs.back()));
+    }
+    BOOST_CHECK_EQUAL(batch.size(), 20U);
+    BOOST_CHECK(batch.Verify());
+
+    // one signature checked against the wrong key
+    batch.clear();
+    for (int i = 0; i < 20; i++) {
+        BOOST_CHECK(batch.Add(i == 12 ? pubkey2 : (i % 7 == 6 ? pubkey2 : pubkey1), hashes[i], sigs[i]));
+    }
+    BOOST_CHECK(!batch.Verify());
+
+    // one signature over the wrong message
+    batch.clear();
+    for (int i = 0; i < 20; i++) {
+        BOOST_CHECK(batch.Add(i % 7 == 6 ? pubkey2 : pubkey1, hashes[(i + (i == 0)) % 20], sigs[i]));
+    }
+    BOOST_CHECK(!batch.Verify());
+
+    // malformed signatures fail the whole batch
+    batch.clear();
+    BOOST_CHECK(batch.Add(pubkey1, hashes[0], sigs[0]));
+    std::vector<unsigned char> shortSig(sigs[1].begin(), sigs[1].end() - 1);
+    BOOST_CHECK(!batch.Add(pubkey1, hashes[1], shortSig));
+    BOOST_CHECK(!batch.Verify());
+    batch.clear();
+    BOOST_CHECK(batch.Add(pubkey1, hashes[0], sigs[0]));
+    BOOST_CHECK(batch.Verify());
+}
+
+BOOST_AUTO_TEST_CASE(pubkey_parse_cache_tests)
+{
+    CKey key1 = DecodeSecret(strSecret1);
+    CKey key1C = DecodeSecret(strSecret1C);
+    CKey key2C = DecodeSecret(strSecret2C);
+    CPubKey pubkey1 = key1.GetPubKey();
+    CPubKey pubkey1C = key1C.GetPubKey();
+    CPubKey pubkey2C = key2C.GetPubKey();
+    BOOST_CHECK(!pubkey1.IsCompressed() && pubkey1C.IsCompressed());
+
+    // The compressed and uncompressed forms of a key share their x coordinate
+    // and so their parse cache slot; alternate between them so that each
+    // lookup replaces the other form.
+    for (int i = 0; i < 4; i++) {
+        std::string msg = "A message to be signed" + std::to_string(i);
+        uint256 hash = Hash(msg.begin(), msg.end());
+        std::vector<unsigned char> sig, sigC;
+        BOOST_CHECK(key1C.Sign_Schnorr(hash, sigC));
+        BOOST_CHECK(key1.Sign_ECDSA(hash, sig));
+        BOOST_CHECK(pubkey1C.Verify_Schnorr(hash, sigC));
+        BOOST_CHECK(pubkey1.Verify_ECDSA(hash, sig));
+        BOOST_CHECK(pubkey1.Verify_Schnorr(hash, sigC));
+        BOOST_CHECK(pubkey1C.Verify_ECDSA(hash, sig));
+        BOOST_CHECK(!pubkey2C.Verify_Schnorr(hash, sigC));
+        BOOST_CHECK(!pubkey2C.Verify_ECDSA(hash, sig));
+    }
+}
+
 BOOST_AUTO_TEST_CASE(pubkey_combine_tests)
 {
     auto pubkeys = validPubKeys(15);
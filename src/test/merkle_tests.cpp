@@ -3,10 +3,13 @@
 // Distributed under the MIT software license, see the accompanying
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
+#include <checkqueue.h>
 #include <consensus/merkle.h>
 #include <test/test_tapyrus.h>
+#include <validation.h>
 
 #include <boost/test/unit_test.hpp>
+#include <boost/thread/thread.hpp>
 
 BOOST_FIXTURE_TEST_SUITE(merkle_tests, TestingSetup)
 
@@ -183,6 +186,12 @@ static inline int ctz(uint32_t i) {
 
 BOOST_AUTO_TEST_CASE(merkle_test)
 {
+    CCheckQueue<CBlockMerkleCheck> queue(1);
+    boost::thread_group tg;
+    for (int i = 0; i < 2; i++) {
+        tg.create_thread([&]{queue.Thread();});
+    }
+
     for (int i = 0; i < 32; i++) {
         // Try 32 block sizes: all sizes from 0 to 16 inclusive, and then 15 random sizes.
         int ntx = (i <= 16) ? i : 17 + (InsecureRandRange(4000));
@@ -202,6 +211,8 @@ BOOST_AUTO_TEST_CASE(merkle_test)
             block.vtx.resize(ntx);
             for (int j = 0; j < ntx; j++) {
                 CMutableTransaction mtx;
+                mtx.vin.resize(1);
+                mtx.vin[0].scriptSig = CScript() << OP_TRUE; // Make the MalFix hashes differ from the txids
                 mtx.nLockTime = j;
                 block.vtx[j] = MakeTransactionRef(std::move(mtx));
             }
@@ -232,6 +243,19 @@ BOOST_AUTO_TEST_CASE(merkle_test)
             BOOST_CHECK((newRoot == uint256()) == (ntx == 0));
             BOOST_CHECK(oldMutated == newMutated);
             BOOST_CHECK(newMutated == !!mutate);
+            // Both roots computed together, inline and split into subtrees.
+            uint256 dualRoot, dualImRoot;
+            bool dualMutated = false;
+            BlockDualMerkleRoot(block, dualRoot, dualImRoot, &dualMutated);
+            BOOST_CHECK(dualRoot == newRoot);
+            BOOST_CHECK(dualImRoot == BlockMerkleRoot(block, nullptr, true));
+            BOOST_CHECK(dualMutated == newMutated);
+            uint256 splitRoot, splitImRoot;
+            bool splitMutated = false;
+            ComputeBlockMerkleRoots(block, splitRoot, splitImRoot, &splitMutated, &queue);
+            BOOST_CHECK(splitRoot == dualRoot);
+            BOOST_CHECK(splitImRoot == dualImRoot);
+            BOOST_CHECK(splitMutated == dualMutated);
             // If no mutation was done (once for every ntx value), try up to 16 branches.
             if (mutate == 0) {
                 for (int loop = 0; loop < std::min(ntx, 16); loop++) {
@@ -248,6 +272,8 @@ BOOST_AUTO_TEST_CASE(merkle_test)
             }
         }
     }
+    tg.interrupt_all();
+    tg.join_all();
 }
 
 BOOST_AUTO_TEST_SUITE_END()
\ No newline at end of file
@@ -6,6 +6,7 @@
 #include <test/data/script_tests.json.h>
 
 #include <core_io.h>
+#include <hash.h>
 #include <key.h>
 #include <keystore.h>
 #include <policy/policy.h>
@@ -2516,4 +2517,147 @@ BOOST_AUTO_TEST_CASE(coloredScripts)
 }
 
 #endif
+
+/** Accepts a signature by its first byte, so that the script code does not matter. */
+class TemplateTestChecker : public BaseSignatureChecker
+{
+public:
+    bool CheckSig(const std::vector<unsigned char>& vchSig, const std::vector<unsigned char>& vchPubKey, const CScript& scriptCode, SigVersion sigversion) const override
+    {
+        return !vchSig.empty() && (vchSig[0] & 1);
+    }
+};
+
+static std::vector<unsigned char> RandomTemplatePubKey()
+{
+    std::vector<unsigned char> pubkey = insecure_rand_ctx.randbytes(33);
+    pubkey[0] = InsecureRandBool() ? 0x02 : 0x03;
+    if (InsecureRandRange(8) == 0) pubkey.resize(InsecureRandRange(40));
+    return pubkey;
+}
+
+static std::vector<unsigned char> RandomTemplateSig()
+{
+    switch (InsecureRandRange(4)) {
+    case 0: return std::vector<unsigned char>();
+    case 1: return insecure_rand_ctx.randbytes(InsecureRandRange(80));
+    default: {
+        // A Schnorr signature with a valid hash type
+        std::vector<unsigned char> sig = insecure_rand_ctx.randbytes(CPubKey::COMPACT_SIGNATURE_SIZE);
+        sig.back() = SIGHASH_ALL;
+        return sig;
+    }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(script_template_match)
+{
+    const std::vector<unsigned char> colorid = ParseHex("c11863143c14c5166804bd19203356da136c985678cd4d27a1b8c6329604903262");
+    const std::vector<unsigned char> hash = ParseHex("1018853670f9f3b0582c5b9ee8ce93764ac32b93");
+
+    const CScript p2pkh = CScript() << OP_DUP << OP_HASH160 << hash << OP_EQUALVERIFY << OP_CHECKSIG;
+    const CScript p2sh = CScript() << OP_HASH160 << hash << OP_EQUAL;
+    const CScript cp2pkh = CScript() << colorid << OP_COLOR << OP_DUP << OP_HASH160 << hash << OP_EQUALVERIFY << OP_CHECKSIG;
+    const CScript cp2sh = CScript() << colorid << OP_COLOR << OP_HASH160 << hash << OP_EQUAL;
+    const std::pair<CScript, std::pair<ScriptTemplate, txnouttype>> templates[] = {
+        {p2pkh, {ScriptTemplate::P2PKH, TX_PUBKEYHASH}},
+        {p2sh, {ScriptTemplate::P2SH, TX_SCRIPTHASH}},
+        {cp2pkh, {ScriptTemplate::CP2PKH, TX_COLOR_PUBKEYHASH}},
+        {cp2sh, {ScriptTemplate::CP2SH, TX_COLOR_SCRIPTHASH}},
+    };
+    for (const auto& t : templates) {
+        const ScriptTemplateMatch match = MatchScriptTemplate(t.first);
+        BOOST_CHECK(match.type == t.second.first);
+        BOOST_CHECK(std::vector<unsigned char>(match.hash, match.hash + 20) == hash);
+        const bool fColored = t.second.first == ScriptTemplate::CP2PKH || t.second.first == ScriptTemplate::CP2SH;
+        BOOST_CHECK_EQUAL(match.colorid != nullptr, fColored);
+
+        txnouttype type;
+        std::vector<std::vector<unsigned char>> solutions;
+        BOOST_CHECK(Solver(t.first, type, solutions));
+        BOOST_CHECK_EQUAL(type, t.second.second);
+        BOOST_CHECK_EQUAL(solutions.size(), fColored ? 2U : 1U);
+        BOOST_CHECK(solutions[0] == hash);
+        if (fColored) BOOST_CHECK(solutions[1] == colorid);
+
+        // A leading OP_NOP keeps the meaning but defeats the byte layout match,
+        // so these go through the generic opcode scans.
+        const CScript generic = (CScript() << OP_NOP) + t.first;
+        BOOST_CHECK(MatchScriptTemplate(generic).type == ScriptTemplate::NONE);
+        BOOST_CHECK_EQUAL(t.first.IsColoredScript(), fColored);
+        BOOST_CHECK_EQUAL(generic.IsColoredScript(), fColored);
+        BOOST_CHECK(GetColorIdFromScript(t.first) == (fColored ? ColorIdentifier(colorid) : ColorIdentifier()));
+
+        // Any other length or a different opcode is not a template
+        CScript truncated(t.first.begin(), t.first.end() - 1);
+        BOOST_CHECK(MatchScriptTemplate(truncated).type == ScriptTemplate::NONE);
+        CScript changed(t.first);
+        changed.back() = OP_NOP;
+        BOOST_CHECK(MatchScriptTemplate(changed).type == ScriptTemplate::NONE);
+    }
+
+    // An unknown token type is not a colored template
+    std::vector<unsigned char> badcolorid(colorid);
+    badcolorid[0] = 0xc4;
+    BOOST_CHECK(MatchScriptTemplate(CScript() << badcolorid << OP_COLOR << OP_HASH160 << hash << OP_EQUAL).type == ScriptTemplate::NONE);
+}
+
+BOOST_AUTO_TEST_CASE(script_template_eval)
+{
+    // EvalScript runs the standard templates without opcode dispatch. Check the
+    // outcome against the generic interpreter loop, which runs them when they
+    // are prefixed with an OP_NOP, on random and edge case stacks.
+    const TemplateTestChecker checker;
+    const unsigned int flags[] = {0, SCRIPT_VERIFY_WITNESS_PUBKEYTYPE, SCRIPT_VERIFY_NULLFAIL, SCRIPT_VERIFY_CONST_SCRIPTCODE, STANDARD_SCRIPT_VERIFY_FLAGS, MANDATORY_SCRIPT_VERIFY_FLAGS};
+    const size_t stackSizes[] = {0, 1, 2, 3, MAX_STACK_SIZE - 2, MAX_STACK_SIZE - 1, MAX_STACK_SIZE};
+
+    for (int i = 0; i < 20000; i++) {
+        const std::vector<unsigned char> pubkey = RandomTemplatePubKey();
+        const std::vector<unsigned char> sig = RandomTemplateSig();
+        std::vector<unsigned char> hash = InsecureRandBool() ? ToByteVector(Hash160(pubkey)) : insecure_rand_ctx.randbytes(20);
+        std::vector<unsigned char> colorid = insecure_rand_ctx.randbytes(33);
+        colorid[0] = 0xc1 + InsecureRandRange(3);
+
+        CScript script;
+        const int type = InsecureRandRange(4);
+        if (type >= 2) script << colorid << OP_COLOR;
+        if (type % 2 == 0) {
+            script << OP_DUP << OP_HASH160 << hash << OP_EQUALVERIFY << OP_CHECKSIG;
+        } else {
+            script << OP_HASH160 << hash << OP_EQUAL;
+        }
+        BOOST_CHECK(MatchScriptTemplate(script).type != ScriptTemplate::NONE);
+        const CScript generic = (CScript() << OP_NOP) + script;
+
+        std::vector<std::vector<unsigned char>> stack;
+        const size_t nSize = InsecureRandBool() ? stackSizes[InsecureRandRange(sizeof(stackSizes) / sizeof(stackSizes[0]))] : InsecureRandRange(4);
+        for (size_t j = 0; j < nSize; j++) {
+            if (j + 2 == nSize) stack.push_back(sig);
+            else if (j + 1 == nSize) stack.push_back(pubkey);
+            else stack.push_back(insecure_rand_ctx.randbytes(InsecureRandRange(3)));
+        }
+        std::vector<std::vector<unsigned char>> genericStack(stack);
+
+        const unsigned int nFlags = flags[InsecureRandRange(sizeof(flags) / sizeof(flags[0]))];
+        const SigVersion sigversion = InsecureRandBool() ? SigVersion::BASE : SigVersion::WITNESS_V0;
+
+        // No color id output, an unset one, or one set by an earlier OP_COLOR
+        ColorIdentifier colorId, genericColorId;
+        const int colorCase = InsecureRandRange(3);
+        if (colorCase == 2) {
+            colorId = genericColorId = ColorIdentifier(colorid);
+        }
+        ColorIdentifier* pColorId = colorCase ? &colorId : nullptr;
+        ColorIdentifier* pGenericColorId = colorCase ? &genericColorId : nullptr;
+
+        ScriptError err, genericErr;
+        const bool ret = EvalScript(stack, script, nFlags, checker, sigversion, pColorId, &err);
+        const bool genericRet = EvalScript(genericStack, generic, nFlags, checker, sigversion, pGenericColorId, &genericErr);
+        BOOST_CHECK_EQUAL(ret, genericRet);
+        BOOST_CHECK_EQUAL(err, genericErr);
+        BOOST_CHECK(stack == genericStack);
+        BOOST_CHECK(colorId == genericColorId);
+    }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
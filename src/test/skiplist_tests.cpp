@@ -4,6 +4,8 @@
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
 #include <chain.h>
+#include <clientversion.h>
+#include <streams.h>
 #include <util.h>
 #include <test/test_tapyrus.h>
 
@@ -178,4 +180,72 @@ BOOST_AUTO_TEST_CASE(findearliestatleast_edge_test)
     BOOST_CHECK(!chain.FindEarliestAtLeast(int64_t(std::numeric_limits<unsigned int>::max()) + 1));
 }
 
+BOOST_AUTO_TEST_CASE(blockindex_proof_xfield_test)
+{
+    CBlockHeader header;
+    header.nFeatures = CBlockHeader::TAPYRUS_BLOCK_FEATURES;
+    header.proof = insecure_rand_ctx.randbytes(64);
+
+    // the proof of a valid block is kept inline, without out of line data
+    CBlockIndex index(header);
+    BOOST_CHECK(index.GetProof() == header.proof);
+    BOOST_CHECK(index.GetXField().empty());
+    BOOST_CHECK(index.GetBlockHeader().GetHash() == header.GetHash());
+
+    // xfield and an oversized proof round trip through the disk format
+    header.xfieldType = 1;
+    header.xfield = insecure_rand_ctx.randbytes(33);
+    header.proof = insecure_rand_ctx.randbytes(70);
+    CBlockIndex index2(header);
+    BOOST_CHECK(index2.GetProof() == header.proof);
+    BOOST_CHECK(index2.GetXField() == header.xfield);
+
+    CDataStream ss(SER_DISK, CLIENT_VERSION);
+    ss << CDiskBlockIndex(&index2);
+    CDiskBlockIndex diskindex;
+    ss >> diskindex;
+    BOOST_CHECK(diskindex.GetProof() == header.proof);
+    BOOST_CHECK(diskindex.GetXField() == header.xfield);
+    BOOST_CHECK(diskindex.GetBlockHash() == header.GetHash());
+
+    // shrinking the proof back to inline size keeps the xfield
+    index2.SetProof(std::vector<unsigned char>(64, 0x01));
+    BOOST_CHECK(index2.GetProof() == std::vector<unsigned char>(64, 0x01));
+    BOOST_CHECK(index2.GetXField() == header.xfield);
+    index2.SetXField(std::vector<unsigned char>());
+    BOOST_CHECK(index2.GetXField().empty());
+    BOOST_CHECK(index2.GetProof() == std::vector<unsigned char>(64, 0x01));
+
+    // a copy shares the out of line data but not later changes
+    CBlockIndex index3;
+    index3.CopyXFieldAndProof(diskindex);
+    BOOST_CHECK(index3.GetProof() == header.proof);
+    BOOST_CHECK(index3.GetXField() == header.xfield);
+    diskindex.SetXField(std::vector<unsigned char>());
+    BOOST_CHECK(index3.GetXField() == header.xfield);
+}
+
+BOOST_AUTO_TEST_CASE(blockindex_arena_test)
+{
+    CBlockIndexArena arena;
+    std::vector<CBlockIndex*> vIndex;
+    const size_t count = CBlockIndexArena::SLAB_SIZE * 2 + 10;
+    for (size_t i = 0; i < count; i++) {
+        CBlockIndex* pindex = arena.Create();
+        pindex->nHeight = i;
+        pindex->pprev = vIndex.empty() ? nullptr : vIndex.back();
+        pindex->BuildSkip();
+        vIndex.push_back(pindex);
+    }
+    BOOST_CHECK_EQUAL(arena.size(), count);
+    for (size_t i = 0; i < count; i++)
+        BOOST_CHECK_EQUAL(vIndex[i]->nHeight, (int)i);
+    BOOST_CHECK(vIndex.back()->GetAncestor(5) == vIndex[5]);
+
+    arena.Clear();
+    BOOST_CHECK_EQUAL(arena.size(), 0U);
+    BOOST_CHECK_EQUAL(arena.Create()->nHeight, 0);
+    BOOST_CHECK_EQUAL(arena.size(), 1U);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,101 @@
+// Copyright (c) 2020 Chaintope Inc.
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <smallmap.h>
+
+#include <primitives/transaction.h>
+#include <script/script.h>
+#include <coloridentifier.h>
+#include <test/test_tapyrus.h>
+
+#include <map>
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_FIXTURE_TEST_SUITE(smallmap_tests, BasicTestingSetup)
+
+template <typename A, typename B>
+static bool SameContents(const A& a, const B& b)
+{
+    if (a.size() != b.size()) return false;
+    auto it = b.begin();
+    for (const auto& entry : a) {
+        if (!(entry.first == it->first) || entry.second != it->second) return false;
+        ++it;
+    }
+    return true;
+}
+
+BOOST_AUTO_TEST_CASE(smallmap_matches_map)
+{
+    // Random operations on small key ranges, so that the maps grow past the
+    // inline capacity and shrink back.
+    for (int round = 0; round < 64; round++) {
+        std::map<int, int64_t> real;
+        smallmap<2, int, int64_t> small;
+        const int range = 1 + InsecureRandRange(8);
+        for (int i = 0; i < 200; i++) {
+            const int key = InsecureRandRange(range);
+            const int64_t value = InsecureRand32();
+            switch (InsecureRandRange(6)) {
+            case 0:
+                real[key] += value;
+                small[key] += value;
+                break;
+            case 1: {
+                bool inserted = real.emplace(key, value).second;
+                auto ret = small.emplace(key, value);
+                BOOST_CHECK_EQUAL(inserted, ret.second);
+                BOOST_CHECK_EQUAL(ret.first->first, key);
+                break;
+            }
+            case 2:
+                BOOST_CHECK_EQUAL(real.erase(key), small.erase(key));
+                break;
+            case 3:
+                BOOST_CHECK_EQUAL(real.count(key), small.count(key));
+                BOOST_CHECK((real.find(key) == real.end()) == (small.find(key) == small.end()));
+                break;
+            case 4:
+                if (real.count(key)) {
+                    BOOST_CHECK_EQUAL(real.at(key), small.at(key));
+                } else {
+                    BOOST_CHECK_THROW(small.at(key), std::out_of_range);
+                }
+                break;
+            case 5:
+                if (InsecureRandRange(16) == 0) {
+                    real.clear();
+                    small.clear();
+                }
+                break;
+            }
+            BOOST_CHECK(SameContents(real, small));
+        }
+        smallmap<2, int, int64_t> copy(small);
+        BOOST_CHECK(copy == small);
+        copy[range] = 1;
+        BOOST_CHECK(copy != small);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(smallmap_colored_balances)
+{
+    // TPC sorts first, like in the std::map the balances used to be kept in
+    const ColorIdentifier tpc;
+    const ColorIdentifier token1(CScript() << OP_TRUE);
+    const ColorIdentifier token2(COutPoint(InsecureRand256(), 0), TokenTypes::NFT);
+    TxColoredCoinBalancesMap balances;
+    balances[token2] = 1;
+    balances[token1] += 10;
+    balances[tpc] = 100;
+    balances[token1] += 10;
+
+    std::map<ColorIdentifier, CAmount, ColorIdentifierCompare> expected{{tpc, 100}, {token1, 20}, {token2, 1}};
+    BOOST_CHECK(SameContents(balances, expected));
+    BOOST_CHECK(balances.begin()->first == tpc);
+    BOOST_CHECK_EQUAL(balances.at(token1), 20);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,199 @@
+// Copyright (c) 2019 Chaintope Inc.
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <script/tapyrusconsensus.h>
+
+#include <key.h>
+#include <keystore.h>
+#include <primitives/transaction.h>
+#include <script/script_error.h>
+#include <script/sign.h>
+#include <script/standard.h>
+#include <streams.h>
+#include <test/test_tapyrus.h>
+#include <version.h>
+
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_FIXTURE_TEST_SUITE(tapyrusconsensus_tests, BasicTestingSetup)
+
+namespace {
+
+/** A signed transaction and the outputs it spends, as seen through the library interface. */
+struct ConsensusTx
+{
+    CMutableTransaction tx;
+    std::vector<CTxOut> vSpentOut;
+
+    std::vector<unsigned char> Serialize() const
+    {
+        CDataStream stream(SER_NETWORK, PROTOCOL_VERSION);
+        stream << tx;
+        return std::vector<unsigned char>(stream.begin(), stream.end());
+    }
+
+    std::vector<bitcoinconsensus_spent_output> SpentOutputs() const
+    {
+        std::vector<bitcoinconsensus_spent_output> vSpent;
+        for (const CTxOut& out : vSpentOut) {
+            vSpent.push_back({out.scriptPubKey.data(), (unsigned int)out.scriptPubKey.size(), out.nValue});
+        }
+        return vSpent;
+    }
+
+    int Verify(unsigned int options, unsigned int nThreads, std::vector<int>& vErrors, bitcoinconsensus_error& err) const
+    {
+        const std::vector<unsigned char> vchTx = Serialize();
+        const std::vector<bitcoinconsensus_spent_output> vSpent = SpentOutputs();
+        vErrors.assign(vSpent.size(), -1);
+        return bitcoinconsensus_verify_transaction(vchTx.data(), vchTx.size(), vSpent.data(), vSpent.size(), bitcoinconsensus_SCRIPT_FLAGS_VERIFY_NONE, options, nThreads, vErrors.data(), &err);
+    }
+};
+
+/** ECDSA and Schnorr P2PKH inputs, and Schnorr CP2PKH inputs spending a colored coin. */
+ConsensusTx CreateSignedTransaction(size_t nInputs)
+{
+    CBasicKeyStore keystore;
+    CKey key;
+    key.MakeNewKey(true);
+    keystore.AddKey(key);
+    ColorIdentifier colorId(COutPoint(InsecureRand256(), 0), TokenTypes::REISSUABLE);
+
+    ConsensusTx ctx;
+    ctx.tx.nFeatures = 1;
+    for (size_t i = 0; i < nInputs; i++) {
+        ctx.tx.vin.emplace_back(COutPoint(InsecureRand256(), i));
+        ctx.vSpentOut.emplace_back(1000 + i, GetScriptForDestination(key.GetPubKey().GetID(), i % 3 == 2 ? &colorId : nullptr));
+    }
+    ctx.tx.vout.emplace_back(50000, GetScriptForDestination(key.GetPubKey().GetID()));
+
+    std::vector<const CTxOut*> vSpent;
+    for (const CTxOut& out : ctx.vSpentOut) {
+        vSpent.push_back(&out);
+    }
+    for (SignatureScheme scheme : {SignatureScheme::ECDSA, SignatureScheme::SCHNORR}) {
+        std::vector<SignatureData> vSigData(nInputs);
+        ProduceSignatures(keystore, ctx.tx, vSpent, SIGHASH_ALL, scheme, nullptr, vSigData, 1);
+        for (size_t i = 0; i < nInputs; i++) {
+            if ((i % 3 == 0) == (scheme == SignatureScheme::ECDSA)) {
+                BOOST_CHECK(vSigData[i].complete);
+                ctx.tx.vin[i].scriptSig = vSigData[i].scriptSig;
+            }
+        }
+    }
+    return ctx;
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_CASE(verify_transaction)
+{
+    ConsensusTx ctx = CreateSignedTransaction(30);
+    const std::vector<unsigned int> vOptions{bitcoinconsensus_VERIFY_TX_NONE, bitcoinconsensus_VERIFY_TX_BATCH_SCHNORR};
+    const std::vector<unsigned int> vThreads{0, 1, 3, 64};
+    std::vector<int> vErrors;
+    bitcoinconsensus_error err;
+
+    for (unsigned int options : vOptions) {
+        for (unsigned int nThreads : vThreads) {
+            BOOST_CHECK_EQUAL(ctx.Verify(options, nThreads, vErrors, err), 1);
+            BOOST_CHECK_EQUAL(err, bitcoinconsensus_ERR_OK);
+            for (int e : vErrors) {
+                BOOST_CHECK_EQUAL(e, SCRIPT_ERR_OK);
+            }
+        }
+    }
+
+    // Break a Schnorr, a colored Schnorr and an ECDSA signature. Only their
+    // inputs fail, whichever thread and batch they end up in.
+    for (size_t i : {4, 8, 21}) {
+        std::vector<unsigned char> vchSig(ctx.tx.vin[i].scriptSig.begin() + 1, ctx.tx.vin[i].scriptSig.begin() + 1 + ctx.tx.vin[i].scriptSig[0]);
+        vchSig[vchSig.size() - 2] ^= 1;
+        std::vector<unsigned char> vchPubKey(ctx.tx.vin[i].scriptSig.begin() + 2 + vchSig.size(), ctx.tx.vin[i].scriptSig.end());
+        ctx.tx.vin[i].scriptSig = CScript() << vchSig << vchPubKey;
+    }
+    ctx.tx.vin[9].scriptSig = CScript() << OP_0;
+    for (unsigned int options : vOptions) {
+        for (unsigned int nThreads : vThreads) {
+            BOOST_CHECK_EQUAL(ctx.Verify(options, nThreads, vErrors, err), 0);
+            BOOST_CHECK_EQUAL(err, bitcoinconsensus_ERR_OK);
+            for (size_t i = 0; i < vErrors.size(); i++) {
+                if (i == 4 || i == 8 || i == 21) {
+                    BOOST_CHECK_EQUAL(vErrors[i], SCRIPT_ERR_EVAL_FALSE);
+                } else if (i == 9) {
+                    BOOST_CHECK_EQUAL(vErrors[i], SCRIPT_ERR_EQUALVERIFY);
+                } else {
+                    BOOST_CHECK_EQUAL(vErrors[i], SCRIPT_ERR_OK);
+                }
+            }
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(verify_transaction_batch_fallback)
+{
+    // A script that succeeds exactly when the signature is invalid. Batching
+    // first reports the signatures as valid, which fails the script, so the
+    // inputs must be checked again one signature at a time.
+    CKey key;
+    key.MakeNewKey(true);
+    ConsensusTx ctx;
+    ctx.tx.nFeatures = 1;
+    ctx.tx.vout.emplace_back(1000, CScript() << OP_TRUE);
+    for (int i = 0; i < 2; i++) {
+        ctx.tx.vin.emplace_back(COutPoint(InsecureRand256(), i));
+        ctx.vSpentOut.emplace_back(1000, CScript() << ToByteVector(key.GetPubKey()) << OP_CHECKSIG << OP_NOT);
+    }
+    for (int i = 0; i < 2; i++) {
+        std::vector<unsigned char> vchSig;
+        BOOST_CHECK(key.Sign_Schnorr(SignatureHash(ctx.vSpentOut[i].scriptPubKey, ctx.tx, i, SIGHASH_ALL, 1000, SigVersion::BASE), vchSig));
+        vchSig[i == 0 ? 5 : 0] ^= 1;
+        vchSig.push_back(SIGHASH_ALL);
+        ctx.tx.vin[i].scriptSig = CScript() << vchSig;
+    }
+
+    std::vector<int> vErrors;
+    bitcoinconsensus_error err;
+    for (unsigned int options : {bitcoinconsensus_VERIFY_TX_NONE, bitcoinconsensus_VERIFY_TX_BATCH_SCHNORR}) {
+        BOOST_CHECK_EQUAL(ctx.Verify(options, 1, vErrors, err), 1);
+        BOOST_CHECK_EQUAL(vErrors[0], SCRIPT_ERR_OK);
+        BOOST_CHECK_EQUAL(vErrors[1], SCRIPT_ERR_OK);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(verify_transaction_errors)
+{
+    const ConsensusTx ctx = CreateSignedTransaction(3);
+    std::vector<unsigned char> vchTx = ctx.Serialize();
+    std::vector<bitcoinconsensus_spent_output> vSpent = ctx.SpentOutputs();
+    int errors[3];
+    bitcoinconsensus_error err;
+
+    BOOST_CHECK_EQUAL(bitcoinconsensus_version(), 2U);
+
+    BOOST_CHECK_EQUAL(bitcoinconsensus_verify_transaction(vchTx.data(), vchTx.size(), vSpent.data(), vSpent.size(), 0, 0, 1, nullptr, &err), 1);
+    BOOST_CHECK_EQUAL(err, bitcoinconsensus_ERR_OK);
+
+    // One spent output per input
+    BOOST_CHECK_EQUAL(bitcoinconsensus_verify_transaction(vchTx.data(), vchTx.size(), vSpent.data(), 2, 0, 0, 1, errors, &err), 0);
+    BOOST_CHECK_EQUAL(err, bitcoinconsensus_ERR_TX_INDEX);
+    BOOST_CHECK_EQUAL(bitcoinconsensus_verify_transaction(vchTx.data(), vchTx.size(), nullptr, 3, 0, 0, 1, errors, &err), 0);
+    BOOST_CHECK_EQUAL(err, bitcoinconsensus_ERR_TX_INDEX);
+
+    BOOST_CHECK_EQUAL(bitcoinconsensus_verify_transaction(vchTx.data(), vchTx.size(), vSpent.data(), vSpent.size(), 0, bitcoinconsensus_VERIFY_TX_ALL + 1, 1, errors, &err), 0);
+    BOOST_CHECK_EQUAL(err, bitcoinconsensus_ERR_INVALID_FLAGS);
+    BOOST_CHECK_EQUAL(bitcoinconsensus_verify_transaction(vchTx.data(), vchTx.size(), vSpent.data(), vSpent.size(), bitcoinconsensus_SCRIPT_FLAGS_VERIFY_WITNESS, 0, 1, errors, &err), 0);
+    BOOST_CHECK_EQUAL(err, bitcoinconsensus_ERR_INVALID_FLAGS);
+
+    BOOST_CHECK_EQUAL(bitcoinconsensus_verify_transaction(vchTx.data(), vchTx.size() - 1, vSpent.data(), vSpent.size(), 0, 0, 1, errors, &err), 0);
+    BOOST_CHECK_EQUAL(err, bitcoinconsensus_ERR_TX_DESERIALIZE);
+
+    vchTx.push_back(0);
+    BOOST_CHECK_EQUAL(bitcoinconsensus_verify_transaction(vchTx.data(), vchTx.size(), vSpent.data(), vSpent.size(), 0, 0, 1, errors, &err), 0);
+    BOOST_CHECK_EQUAL(err, bitcoinconsensus_ERR_TX_SIZE_MISMATCH);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -275,6 +275,28 @@ BOOST_AUTO_TEST_CASE(basic_transaction_tests)
     BOOST_CHECK_MESSAGE(!CheckTransaction(tx, state) || !state.IsValid(), "Transaction with duplicate txins should be invalid.");
 }
 
+BOOST_AUTO_TEST_CASE(transaction_hashes)
+{
+    // the single pass hashes match the separate serializations
+    CMutableTransaction tx;
+    tx.nLockTime = 42;
+    for (int i = 0; i < 3; i++) {
+        tx.vin.emplace_back(InsecureRand256(), i, CScript() << std::vector<unsigned char>(i * 40, 0x01));
+        tx.vout.emplace_back(i * CENT, CScript() << OP_TRUE);
+    }
+    CTransaction ctx(tx);
+    BOOST_CHECK(ctx.GetHash() == tx.GetHash());
+    BOOST_CHECK(ctx.GetHashMalFix() == tx.GetHashMalFix());
+    BOOST_CHECK(ctx.GetHash() != ctx.GetHashMalFix());
+
+    // only scriptSig is left out of the MalFix hash
+    tx.vin[1].scriptSig = CScript() << OP_FALSE;
+    CTransaction ctx2(std::move(tx));
+    BOOST_CHECK(ctx2.GetHash() != ctx.GetHash());
+    BOOST_CHECK(ctx2.GetHashMalFix() == ctx.GetHashMalFix());
+    BOOST_CHECK(ctx2.GetHash() == CMutableTransaction(ctx2).GetHash());
+}
+
 //
 // Helper: create two dummy transactions, each with
 // two outputs.  The first has 11 and 50 CENT outputs
@@ -501,4 +523,59 @@ BOOST_AUTO_TEST_CASE(test_IsStandard)
     BOOST_CHECK(!IsStandardTx(t, reason));
 }
 
+BOOST_AUTO_TEST_CASE(produce_signatures_parallel)
+{
+    // P2PKH and P2SH 1-of-2 multisig inputs, with a few left unsigned and a
+    // few whose key is unknown.
+    CBasicKeyStore keystore;
+    CKey key[3];
+    for (int i = 0; i < 3; i++) {
+        key[i].MakeNewKey(i != 1);
+    }
+    keystore.AddKey(key[0]);
+    keystore.AddKey(key[1]);
+    const CScript multisig = GetScriptForMultisig(1, {key[2].GetPubKey(), key[1].GetPubKey()});
+    keystore.AddCScript(multisig);
+
+    CMutableTransaction tx;
+    tx.nFeatures = 1;
+    std::vector<CTxOut> vSpentOut;
+    for (int i = 0; i < 100; i++) {
+        tx.vin.emplace_back(COutPoint(InsecureRand256(), i));
+        CScript scriptPubKey;
+        if (i % 3 == 0) {
+            scriptPubKey = GetScriptForDestination(CScriptID(multisig));
+        } else {
+            scriptPubKey = GetScriptForDestination(key[i % 10 == 1 ? 2 : 0].GetPubKey().GetID());
+        }
+        vSpentOut.emplace_back(1000 + i, scriptPubKey);
+    }
+    tx.vout.emplace_back(50000, GetScriptForDestination(key[0].GetPubKey().GetID()));
+    std::vector<const CTxOut*> vSpent;
+    for (int i = 0; i < 100; i++) {
+        vSpent.push_back(i % 7 == 6 ? nullptr : &vSpentOut[i]);
+    }
+    const PrecomputedTransactionData txdata(tx);
+
+    for (SignatureScheme scheme : {SignatureScheme::ECDSA, SignatureScheme::SCHNORR}) {
+        // Signing is deterministic, so every thread count gives the signatures
+        // that signing the inputs one at a time does.
+        std::vector<SignatureData> vExpected(tx.vin.size());
+        for (size_t i = 0; i < tx.vin.size(); i++) {
+            if (vSpent[i]) {
+                ProduceSignature(keystore, MutableTransactionSignatureCreator(&tx, i, vSpent[i]->nValue, SIGHASH_ALL, scheme), vSpent[i]->scriptPubKey, vExpected[i]);
+            }
+        }
+        for (int nThreads : {1, 2, 4, 16}) {
+            std::vector<SignatureData> vSigData(tx.vin.size());
+            ProduceSignatures(keystore, tx, vSpent, SIGHASH_ALL, scheme, &txdata, vSigData, nThreads);
+            for (size_t i = 0; i < tx.vin.size(); i++) {
+                BOOST_CHECK_EQUAL(vSigData[i].complete, vSpent[i] != nullptr && (i % 3 == 0 || i % 10 != 1));
+                BOOST_CHECK_EQUAL(vSigData[i].complete, vExpected[i].complete);
+                BOOST_CHECK(vSigData[i].scriptSig == vExpected[i].scriptSig);
+            }
+        }
+    }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
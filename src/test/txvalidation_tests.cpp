@@ -172,6 +172,50 @@ BOOST_FIXTURE_TEST_CASE(tx_invalid_token_issue, TestChainSetup)
     BOOST_CHECK_THROW(CreateAndProcessBlock({}, scriptPubKey), std::runtime_error);
 }
 
+BOOST_FIXTURE_TEST_CASE(tx_colorid_validity, BasicTestingSetup)
+{
+    CCoinsView viewDummy;
+    CCoinsViewCache view(&viewDummy);
+    const std::vector<unsigned char> pubkeyHash(20, 0x01);
+    const CScript tpcScript = CScript() << OP_DUP << OP_HASH160 << pubkeyHash << OP_EQUALVERIFY << OP_CHECKSIG;
+    auto coloredScript = [&](const ColorIdentifier& colorId) {
+        return CScript() << colorId.toVector() << OP_COLOR << OP_DUP << OP_HASH160 << pubkeyHash << OP_EQUALVERIFY << OP_CHECKSIG;
+    };
+
+    // one TPC input and one token input
+    COutPoint tpcOutpoint(InsecureRand256(), 0);
+    COutPoint tokenOutpoint(InsecureRand256(), 1);
+    const ColorIdentifier tokenColorId(CScript() << OP_TRUE);
+    view.AddCoin(tpcOutpoint, Coin(CTxOut(10 * CENT, tpcScript), 1, false, TokenTypes::NONE), false);
+    view.AddCoin(tokenOutpoint, Coin(CTxOut(10, coloredScript(tokenColorId)), 1, false, TokenTypes::REISSUABLE), false);
+
+    auto check = [&](const ColorIdentifier& colorId, CAmount nValue) {
+        CMutableTransaction tx;
+        tx.vin.emplace_back(tpcOutpoint);
+        tx.vin.emplace_back(tokenOutpoint);
+        tx.vout.emplace_back(CENT, tpcScript);
+        tx.vout.emplace_back(nValue, coloredScript(colorId));
+        CValidationState state;
+        return CheckColorIdentifierValidity(CTransaction(tx), state, view);
+    };
+
+    // issue from the TPC input
+    BOOST_CHECK(check(ColorIdentifier(tpcScript), 10));
+    BOOST_CHECK(check(ColorIdentifier(tpcOutpoint, TokenTypes::NON_REISSUABLE), 10));
+    BOOST_CHECK(check(ColorIdentifier(tpcOutpoint, TokenTypes::NFT), 1));
+    BOOST_CHECK(!check(ColorIdentifier(tpcOutpoint, TokenTypes::NFT), 2));
+    BOOST_CHECK(!check(ColorIdentifier(tpcOutpoint, TokenTypes::NON_REISSUABLE), 0));
+    // transfer of the token input, which cannot issue
+    BOOST_CHECK(check(tokenColorId, 10));
+    BOOST_CHECK(!check(ColorIdentifier(tokenOutpoint, TokenTypes::NON_REISSUABLE), 10));
+    BOOST_CHECK(!check(ColorIdentifier(CScript() << OP_FALSE), 10));
+
+    // spent inputs do not count
+    view.SpendCoin(tpcOutpoint);
+    BOOST_CHECK(!check(ColorIdentifier(tpcScript), 10));
+    BOOST_CHECK(check(tokenColorId, 10));
+}
+
 /*
 Test token type REISSUABLE
 Txs:
@@ -3,6 +3,7 @@
 // Distributed under the MIT software license, see the accompanying
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
+#include <checkqueue.h>
 #include <consensus/validation.h>
 #include <key.h>
 #include <validation.h>
@@ -19,6 +20,7 @@
 #include <policy/policy.h>
 
 #include <boost/test/unit_test.hpp>
+#include <boost/thread.hpp>
 
 bool CheckInputs(const CTransaction& tx, CValidationState &state, const CCoinsViewCache &inputs, bool fScriptChecks, unsigned int flags, bool cacheSigStore, bool cacheFullScriptStore, PrecomputedTransactionData& txdata, TxColoredCoinBalancesMap& inColoredCoinBalances, std::vector<CScriptCheck> *pvChecks);
 
@@ -470,4 +472,127 @@ BOOST_FIXTURE_TEST_CASE(checkinputs_test, TestChainSetup)
     }
 }
 
+static CMutableTransaction CreateSignedSpend(const CKey& key, const CScript& scriptPubKey, const COutPoint& prevout, CAmount nValue)
+{
+    CMutableTransaction spend;
+    spend.nFeatures = 1;
+    spend.vin.resize(1);
+    spend.vin[0].prevout = prevout;
+    spend.vout.resize(1);
+    spend.vout[0].nValue = nValue;
+    spend.vout[0].scriptPubKey = scriptPubKey;
+
+    std::vector<unsigned char> vchSig;
+    uint256 hash = SignatureHash(scriptPubKey, spend, 0, SIGHASH_ALL, 0, SigVersion::BASE);
+    BOOST_CHECK(key.Sign_Schnorr(hash, vchSig));
+    vchSig.push_back((unsigned char)SIGHASH_ALL);
+    spend.vin[0].scriptSig << vchSig;
+    return spend;
+}
+
+BOOST_FIXTURE_TEST_CASE(mempool_accept_batch, TestChainSetup)
+{
+    CScript scriptPubKey = CScript() <<  ToByteVector(coinbaseKey.GetPubKey()) << OP_CHECKSIG;
+    const CAmount nCoinbaseValue = m_coinbase_txns[0]->vout[0].nValue;
+
+    // A child listed before its parent, two independent spends, a spend with
+    // a bad signature and a double spend of the first independent one.
+    CMutableTransaction parent = CreateSignedSpend(coinbaseKey, scriptPubKey, COutPoint(m_coinbase_txns[0]->GetHashMalFix(), 0), nCoinbaseValue - CENT);
+    CMutableTransaction child = CreateSignedSpend(coinbaseKey, scriptPubKey, COutPoint(parent.GetHashMalFix(), 0), nCoinbaseValue - 2 * CENT);
+    CMutableTransaction spend1 = CreateSignedSpend(coinbaseKey, scriptPubKey, COutPoint(m_coinbase_txns[1]->GetHashMalFix(), 0), nCoinbaseValue - CENT);
+    CMutableTransaction spend2 = CreateSignedSpend(coinbaseKey, scriptPubKey, COutPoint(m_coinbase_txns[2]->GetHashMalFix(), 0), nCoinbaseValue - CENT);
+    CMutableTransaction badSig = CreateSignedSpend(coinbaseKey, scriptPubKey, COutPoint(m_coinbase_txns[3]->GetHashMalFix(), 0), nCoinbaseValue - CENT);
+    badSig.vout[0].nValue -= CENT;
+    CMutableTransaction doubleSpend = CreateSignedSpend(coinbaseKey, scriptPubKey, COutPoint(m_coinbase_txns[1]->GetHashMalFix(), 0), nCoinbaseValue - 2 * CENT);
+
+    std::vector<CTransactionRef> vtx;
+    for (const CMutableTransaction& mtx : {child, parent, spend1, spend2, badSig, doubleSpend}) {
+        vtx.push_back(MakeTransactionRef(mtx));
+    }
+
+    CCheckQueue<CMempoolInputsCheck> queue(1);
+    boost::thread_group tg;
+    for (int i = 0; i < 3; i++) {
+        tg.create_thread([&]{queue.Thread();});
+    }
+
+    for (CCheckQueue<CMempoolInputsCheck>* pqueue : {(CCheckQueue<CMempoolInputsCheck>*)nullptr, &queue}) {
+        std::vector<CValidationState> vState;
+        std::vector<bool> vAccepted, vMissingInputs;
+        AcceptToMemoryPoolBatch(mempool, vtx, vState, vAccepted, vMissingInputs, nullptr, 0, pqueue);
+
+        BOOST_CHECK_EQUAL(vState.size(), vtx.size());
+        BOOST_CHECK(vAccepted[0] && vAccepted[1] && vAccepted[2] && vAccepted[3]);
+        BOOST_CHECK(!vMissingInputs[0]);
+        BOOST_CHECK(!vAccepted[4] && vState[4].IsInvalid());
+        BOOST_CHECK(vState[4].GetRejectReason().find("mandatory-script-verify-flag-failed") != std::string::npos);
+        BOOST_CHECK(!vAccepted[5] && vState[5].GetRejectReason() == "txn-mempool-conflict");
+        BOOST_CHECK_EQUAL(mempool.size(), 4U);
+
+        // Already known on the second call
+        AcceptToMemoryPoolBatch(mempool, vtx, vState, vAccepted, vMissingInputs, nullptr, 0, pqueue);
+        BOOST_CHECK(std::find(vAccepted.begin(), vAccepted.end(), true) == vAccepted.end());
+        BOOST_CHECK_EQUAL(vState[2].GetRejectReason(), "txn-already-in-mempool");
+        BOOST_CHECK_EQUAL(mempool.size(), 4U);
+
+        mempool.clear();
+    }
+
+    tg.interrupt_all();
+    tg.join_all();
+}
+
+BOOST_FIXTURE_TEST_CASE(script_batch_check, BasicTestingSetup)
+{
+    CKey key;
+    key.MakeNewKey(true);
+    const CPubKey pubkey = key.GetPubKey();
+    const CScript scriptPubKey = GetScriptForDestination(pubkey.GetID());
+
+    CMutableTransaction txCredit;
+    txCredit.nFeatures = 1;
+    txCredit.vin.resize(1);
+    txCredit.vout.resize(8, CTxOut(1000, scriptPubKey));
+
+    // Schnorr signatures on every input but one, which is signed with ECDSA
+    CMutableTransaction mtx;
+    mtx.nFeatures = 1;
+    mtx.vout.emplace_back(8000, scriptPubKey);
+    for (unsigned int i = 0; i < txCredit.vout.size(); i++) {
+        mtx.vin.emplace_back(COutPoint(txCredit.GetHashMalFix(), i));
+    }
+    for (unsigned int i = 0; i < mtx.vin.size(); i++) {
+        uint256 hash = SignatureHash(scriptPubKey, mtx, i, SIGHASH_ALL, 1000, SigVersion::BASE);
+        std::vector<unsigned char> vchSig;
+        BOOST_CHECK(i == 3 ? key.Sign_ECDSA(hash, vchSig) : key.Sign_Schnorr(hash, vchSig));
+        vchSig.push_back(static_cast<unsigned char>(SIGHASH_ALL));
+        mtx.vin[i].scriptSig = CScript() << vchSig << ToByteVector(pubkey);
+    }
+
+    const CTransaction tx(mtx);
+    PrecomputedTransactionData txdata(tx);
+    std::vector<CScriptCheck> vChecks;
+    for (unsigned int i = 0; i < tx.vin.size(); i++) {
+        vChecks.emplace_back(txCredit.vout[i], tx, i, STANDARD_SCRIPT_VERIFY_FLAGS, false, &txdata);
+    }
+    BOOST_CHECK(CScriptBatchCheck(vChecks)());
+
+    // A single bad Schnorr signature fails the whole group
+    CScript::const_iterator pc = mtx.vin[5].scriptSig.begin();
+    opcodetype opcode;
+    std::vector<unsigned char> vchSig;
+    BOOST_CHECK(mtx.vin[5].scriptSig.GetOp(pc, opcode, vchSig));
+    vchSig[10] ^= 1;
+    mtx.vin[5].scriptSig = CScript() << vchSig << ToByteVector(pubkey);
+
+    const CTransaction txBad(mtx);
+    PrecomputedTransactionData txdataBad(txBad);
+    for (unsigned int i = 0; i < txBad.vin.size(); i++) {
+        vChecks.emplace_back(txCredit.vout[i], txBad, i, STANDARD_SCRIPT_VERIFY_FLAGS, false, &txdataBad);
+    }
+    BOOST_CHECK(!CScriptBatchCheck(vChecks)());
+    BOOST_CHECK(!CScriptCheck(txCredit.vout[5], txBad, 5, STANDARD_SCRIPT_VERIFY_FLAGS, false, &txdataBad)());
+    BOOST_CHECK(CScriptCheck(txCredit.vout[4], txBad, 4, STANDARD_SCRIPT_VERIFY_FLAGS, false, &txdataBad)());
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -193,4 +193,70 @@ BOOST_AUTO_TEST_CASE(processnewblock_signals_ordering)
     BOOST_CHECK(chainActive.Tip()->nHeight != 0);
 }
 
+BOOST_AUTO_TEST_CASE(processnewblockheaders_batch_proof)
+{
+    // a chain longer than one proof batch, with a bad proof in the second batch
+    std::vector<CBlockHeader> headers;
+    uint256 prev = FederationParams().GenesisBlock().GetHash();
+    for (int height = 1; height <= (int)BLOCK_PROOF_BATCH_SIZE + 10; height++) {
+        headers.push_back(GoodBlock(prev, height)->GetBlockHeader());
+        prev = headers.back().GetHash();
+    }
+
+    const size_t bad = BLOCK_PROOF_BATCH_SIZE + 5;
+    std::vector<CBlockHeader> badHeaders(headers.begin(), headers.begin() + bad + 1);
+    badHeaders[bad].proof[10] ^= 0x01;
+
+    CValidationState state;
+    CBlockHeader first_invalid;
+    BOOST_CHECK(!ProcessNewBlockHeaders(badHeaders, state, nullptr, &first_invalid));
+    BOOST_CHECK_EQUAL(state.GetRejectReason(), "bad-proof");
+    BOOST_CHECK(first_invalid.GetHash() == badHeaders[bad].GetHash());
+    {
+        LOCK(cs_main);
+        BOOST_CHECK(LookupBlockIndex(badHeaders[bad - 1].GetHash()) != nullptr);
+        BOOST_CHECK(LookupBlockIndex(badHeaders[bad].GetHash()) == nullptr);
+    }
+
+    // the other proofs of the failed batch are still reported as verified
+    std::vector<unsigned char> vValid;
+    CheckBlockHeaders(badHeaders, FederationParams().GetAggPubkeyFromHeight(-1), vValid, nullptr);
+    BOOST_CHECK_EQUAL(vValid.size(), badHeaders.size());
+    BOOST_CHECK_EQUAL(std::count(vValid.begin(), vValid.end(), 0), 1);
+    BOOST_CHECK_EQUAL(vValid[bad], 0);
+
+    CValidationState state2;
+    const CBlockIndex* pindex = nullptr;
+    BOOST_CHECK(ProcessNewBlockHeaders(headers, state2, &pindex));
+    BOOST_CHECK(pindex != nullptr && pindex->GetBlockHash() == headers.back().GetHash());
+}
+
+BOOST_AUTO_TEST_CASE(blockproofcache_hits)
+{
+    // the proof verified with the header is not verified again with the block
+    auto pblock = GoodBlock(FederationParams().GenesisBlock().GetHash(), 1);
+    const BlockProofCacheStats before = GetBlockProofCacheStats();
+
+    CValidationState state;
+    BOOST_CHECK(ProcessNewBlockHeaders({pblock->GetBlockHeader()}, state));
+    const BlockProofCacheStats afterHeader = GetBlockProofCacheStats();
+    BOOST_CHECK_EQUAL(afterHeader.nMisses, before.nMisses + 1);
+    BOOST_CHECK_EQUAL(afterHeader.nHits, before.nHits);
+
+    CValidationState state2;
+    BOOST_CHECK(CheckBlock(*pblock, state2));
+    const BlockProofCacheStats afterBlock = GetBlockProofCacheStats();
+    BOOST_CHECK_EQUAL(afterBlock.nHits, afterHeader.nHits + 1);
+    BOOST_CHECK_EQUAL(afterBlock.nMisses, afterHeader.nMisses);
+
+    // a different proof for the same header is not a hit
+    CBlock badBlock(*pblock);
+    badBlock.proof[10] ^= 0x01;
+    badBlock.fChecked = false;
+    CValidationState state3;
+    BOOST_CHECK(!CheckBlock(badBlock, state3));
+    BOOST_CHECK_EQUAL(state3.GetRejectReason(), "bad-proof");
+    BOOST_CHECK_EQUAL(GetBlockProofCacheStats().nHits, afterBlock.nHits);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -8,6 +8,7 @@
 
 #include <chainparams.h>
 #include <hash.h>
+#include <memusage.h>
 #include <random.h>
 #include <shutdown.h>
 #include <uint256.h>
@@ -80,7 +81,7 @@ std::vector<uint256> CCoinsViewDB::GetHeadBlocks() const {
     return vhashHeadBlocks;
 }
 
-bool CCoinsViewDB::BatchWrite(CCoinsMap &mapCoins, const uint256 &hashBlock) {
+bool CCoinsViewDB::BatchWrite(CCoinsMap &mapCoins, const uint256 &hashBlock, bool erase) {
     CDBBatch batch(db);
     size_t count = 0;
     size_t changed = 0;
@@ -105,7 +106,7 @@ bool CCoinsViewDB::BatchWrite(CCoinsMap &mapCoins, const uint256 &hashBlock) {
     batch.Erase(DB_BEST_BLOCK);
     batch.Write(DB_HEAD_BLOCKS, std::vector<uint256>{hashBlock, old_tip});
 
-    for (CCoinsMap::iterator it = mapCoins.begin(); it != mapCoins.end();) {
+    for (CCoinsMap::iterator it = mapCoins.begin(); it != mapCoins.end(); it = erase ? mapCoins.erase(it) : std::next(it)) {
         if (it->second.flags & CCoinsCacheEntry::DIRTY) {
             CoinEntry entry(&it->first);
             if (it->second.coin.IsSpent())
@@ -115,8 +116,6 @@ bool CCoinsViewDB::BatchWrite(CCoinsMap &mapCoins, const uint256 &hashBlock) {
             changed++;
         }
         count++;
-        CCoinsMap::iterator itOld = it++;
-        mapCoins.erase(itOld);
         if (batch.SizeEstimate() > batch_size) {
             LogPrint(BCLog::COINDB, "Writing partial batch of %.2f MiB\n", batch.SizeEstimate() * (1.0 / 1048576.0));
             db.WriteBatch(batch);
@@ -222,6 +221,136 @@ void CCoinsViewDBCursor::Next()
     }
 }
 
+CCoinsViewFlushBuffer::CCoinsViewFlushBuffer(CCoinsView* viewIn) :
+    CCoinsViewBacked(viewIn), nFrozenUsage(0), fWriting(false), fFailed(false), fStop(false)
+{
+    threadWrite = std::thread(&TraceThread<std::function<void()> >, "coinsflush", std::bind(&CCoinsViewFlushBuffer::ThreadWrite, this));
+}
+
+CCoinsViewFlushBuffer::~CCoinsViewFlushBuffer()
+{
+    {
+        WaitableLock lock(cs);
+        fStop = true;
+    }
+    cond.notify_all();
+    // A pending write is finished first.
+    threadWrite.join();
+}
+
+void CCoinsViewFlushBuffer::ThreadWrite()
+{
+    WaitableLock lock(cs);
+    while (true) {
+        cond.wait(lock, [this] { return fWriting || fStop; });
+        if (!fWriting)
+            return;
+        lock.unlock();
+
+        // Nothing changes mapFrozen and hashFrozen until fWriting is reset.
+        size_t nUsage = memusage::DynamicUsage(mapFrozen);
+        for (const auto& entry : mapFrozen) {
+            nUsage += entry.second.coin.DynamicMemoryUsage();
+        }
+        {
+            WaitableLock lockUsage(cs);
+            nFrozenUsage = nUsage;
+        }
+        int64_t nStart = GetTimeMicros();
+        bool fOk;
+        try {
+            fOk = base->BatchWrite(mapFrozen, hashFrozen, false);
+        } catch (const std::runtime_error& e) {
+            LogPrintf("%s: %s\n", __func__, e.what());
+            fOk = false;
+        }
+        LogPrint(BCLog::COINDB, "Wrote %u coins in the background (%.2fms)\n", (unsigned int)mapFrozen.size(), (GetTimeMicros() - nStart) * 0.001);
+
+        // Keep the entries if the write failed, as the view below may only
+        // have part of them. Otherwise free them outside the lock.
+        CCoinsMap mapWritten;
+        lock.lock();
+        if (fOk) {
+            mapWritten.swap(mapFrozen);
+            hashFrozen.SetNull();
+            nFrozenUsage = 0;
+        } else {
+            fFailed = true;
+        }
+        fWriting = false;
+        lock.unlock();
+        cond.notify_all();
+        mapWritten.clear();
+        lock.lock();
+    }
+}
+
+bool CCoinsViewFlushBuffer::GetCoin(const COutPoint &outpoint, Coin &coin) const
+{
+    {
+        WaitableLock lock(cs);
+        CCoinsMap::const_iterator it = mapFrozen.find(outpoint);
+        if (it != mapFrozen.end()) {
+            coin = it->second.coin;
+            return !coin.IsSpent();
+        }
+    }
+    // Coins missing from mapFrozen are not touched by the write.
+    return base->GetCoin(outpoint, coin);
+}
+
+bool CCoinsViewFlushBuffer::HaveCoin(const COutPoint &outpoint) const
+{
+    Coin coin;
+    return GetCoin(outpoint, coin);
+}
+
+uint256 CCoinsViewFlushBuffer::GetBestBlock() const
+{
+    {
+        WaitableLock lock(cs);
+        if (!hashFrozen.IsNull())
+            return hashFrozen;
+    }
+    return base->GetBestBlock();
+}
+
+bool CCoinsViewFlushBuffer::BatchWrite(CCoinsMap &mapCoins, const uint256 &hashBlock, bool erase)
+{
+    if (!Sync())
+        return false;
+    if (!erase)
+        return base->BatchWrite(mapCoins, hashBlock, false);
+
+    {
+        WaitableLock lock(cs);
+        mapFrozen.swap(mapCoins);
+        hashFrozen = hashBlock;
+        fWriting = true;
+    }
+    cond.notify_all();
+    return true;
+}
+
+CCoinsViewCursor *CCoinsViewFlushBuffer::Cursor() const
+{
+    Sync();
+    return base->Cursor();
+}
+
+bool CCoinsViewFlushBuffer::Sync() const
+{
+    WaitableLock lock(cs);
+    cond.wait(lock, [this] { return !fWriting; });
+    return !fFailed;
+}
+
+size_t CCoinsViewFlushBuffer::DynamicMemoryUsage() const
+{
+    WaitableLock lock(cs);
+    return nFrozenUsage;
+}
+
 bool CBlockTreeDB::WriteBatchSync(const std::vector<std::pair<int, const CBlockFileInfo*> >& fileInfo, int nLastFile, const std::vector<const CBlockIndex*>& blockinfo) {
     CDBBatch batch(*this);
     for (std::vector<std::pair<int, const CBlockFileInfo*> >::const_iterator it=fileInfo.begin(); it != fileInfo.end(); it++) {
@@ -271,8 +400,7 @@ bool CBlockTreeDB::LoadBlockIndexGuts(std::function<CBlockIndex*(const uint256&)
                 pindexNew->hashImMerkleRoot = diskindex.hashImMerkleRoot;
                 pindexNew->nTime          = diskindex.nTime;
                 pindexNew->xfieldType          = diskindex.xfieldType;
-                pindexNew->xfield         = diskindex.xfield;
-                pindexNew->proof          = diskindex.proof;
+                pindexNew->CopyXFieldAndProof(diskindex);
                 pindexNew->nStatus        = diskindex.nStatus;
                 pindexNew->nTx            = diskindex.nTx;
 
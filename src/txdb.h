@@ -11,10 +11,12 @@
 #include <dbwrapper.h>
 #include <chain.h>
 #include <primitives/block.h>
+#include <sync.h>
 
 #include <map>
 #include <memory>
 #include <string>
+#include <thread>
 #include <utility>
 #include <vector>
 
@@ -53,7 +55,7 @@ public:
     bool HaveCoin(const COutPoint &outpoint) const override;
     uint256 GetBestBlock() const override;
     std::vector<uint256> GetHeadBlocks() const override;
-    bool BatchWrite(CCoinsMap &mapCoins, const uint256 &hashBlock) override;
+    bool BatchWrite(CCoinsMap &mapCoins, const uint256 &hashBlock, bool erase = true) override;
     CCoinsViewCursor *Cursor() const override;
 
     //! Attempt to update from an older database format. Returns whether an error occurred.
@@ -83,6 +85,57 @@ private:
     friend class CCoinsViewDB;
 };
 
+/**
+ * CCoinsView layer that writes the coins flushed into it to the view below
+ * on a background thread, so that flushing a large cache does not hold up
+ * validation for the whole database write.
+ *
+ * BatchWrite takes over the passed entries and returns as soon as the
+ * previous write has finished. Until the new one has, lookups are answered
+ * from those entries first, and GetBestBlock reports the block they belong
+ * to. The view below marks the database as partially written for the
+ * duration as usual, so ReplayBlocks recovers from a crash in the middle.
+ *
+ * Lookups may come from several threads at once, as long as the view below
+ * allows it. BatchWrite and Sync must not be called concurrently.
+ */
+class CCoinsViewFlushBuffer final : public CCoinsViewBacked
+{
+private:
+    mutable CWaitableCriticalSection cs;
+    mutable CConditionVariable cond;
+    //! The entries of the last BatchWrite, while they are being written.
+    //! Left alone by both threads until the write has finished.
+    CCoinsMap mapFrozen;
+    uint256 hashFrozen;
+    size_t nFrozenUsage;
+    //! Whether the writer thread has not finished with mapFrozen yet
+    bool fWriting;
+    //! Whether writing mapFrozen failed. It is then kept until shutdown.
+    bool fFailed;
+    bool fStop;
+    std::thread threadWrite;
+
+    void ThreadWrite();
+
+public:
+    explicit CCoinsViewFlushBuffer(CCoinsView* viewIn);
+    ~CCoinsViewFlushBuffer();
+
+    bool GetCoin(const COutPoint &outpoint, Coin &coin) const override;
+    bool HaveCoin(const COutPoint &outpoint) const override;
+    uint256 GetBestBlock() const override;
+    bool BatchWrite(CCoinsMap &mapCoins, const uint256 &hashBlock, bool erase = true) override;
+    CCoinsViewCursor *Cursor() const override;
+
+    //! Wait until the coins of the last BatchWrite are in the view below.
+    //! Returns false if writing them failed.
+    bool Sync() const;
+
+    //! Memory used by the coins not written yet
+    size_t DynamicMemoryUsage() const;
+};
+
 /** Access to the block database (blocks/index/) */
 class CBlockTreeDB : public CDBWrapper
 {
@@ -44,6 +44,7 @@
 
 #include <future>
 #include <sstream>
+#include <unordered_set>
 
 #include <boost/algorithm/string/replace.hpp>
 #include <boost/thread.hpp>
@@ -145,6 +146,9 @@ private:
       */
     std::set<CBlockIndex*> m_failed_blocks;
 
+    //! Storage of every entry of mapBlockIndex
+    CBlockIndexArena m_block_index_arena;
+
     /**
      * the ChainState CriticalSection
      * A lock that must be held when modifying this ChainState - held in ActivateBestChain()
@@ -165,7 +169,7 @@ public:
      * If a block header hasn't already been seen, call CheckBlockHeader on it, ensure
      * that it doesn't descend from an invalid block, and then add it to mapBlockIndex.
      */
-    bool AcceptBlockHeader(const CBlockHeader& block, CValidationState& state, CBlockIndex** ppindex) EXCLUSIVE_LOCKS_REQUIRED(cs_main);
+    bool AcceptBlockHeader(const CBlockHeader& block, CValidationState& state, CBlockIndex** ppindex, bool fCheckProof = true) EXCLUSIVE_LOCKS_REQUIRED(cs_main);
     bool AcceptBlock(const std::shared_ptr<const CBlock>& pblock, CValidationState& state, CBlockIndex** ppindex, bool fRequested, const CDiskBlockPos* dbp, bool* fNewBlock) EXCLUSIVE_LOCKS_REQUIRED(cs_main);
 
     // Block (dis)connection on a given view:
@@ -296,6 +300,7 @@ CBlockIndex* FindForkInGlobalIndex(const CChain& chain, const CBlockLocator& loc
 }
 
 std::unique_ptr<CCoinsViewDB> pcoinsdbview;
+std::unique_ptr<CCoinsViewFlushBuffer> pcoinsflushbuffer;
 std::unique_ptr<CCoinsViewCache> pcoinsTip;
 std::unique_ptr<CBlockTreeDB> pblocktree;
 
@@ -564,6 +569,8 @@ bool CheckColorIdentifierValidity(const CTransaction& tx, CValidationState& stat
 {
     // when this transaction issues or transfers tokens,
     // verify that the color id is valid.
+    std::unordered_set<ColorIdentifier> validColorIds;
+    bool fValidColorIdsComputed = false;
     for(auto& txout:tx.vout)
     {
         if(!txout.scriptPubKey.IsColoredScript())
@@ -580,56 +587,124 @@ bool CheckColorIdentifierValidity(const CTransaction& tx, CValidationState& stat
         if(txout.nValue <= 0)
             return false;
 
-        bool matchFound = false;
-        for(auto txin:tx.vin)
+        //collect every colorid the inputs can issue or transfer, once
+        if(!fValidColorIdsComputed)
         {
-            //match the input coin to the token's colorid
-            const Coin& coin = inputs.AccessCoin(txin.prevout);
-            ColorIdentifier coinColorId;
-
-            switch(coin.type)
+            validColorIds.reserve(tx.vin.size() * 3);
+            for(const auto& txin:tx.vin)
             {
-                // when the coin is TPC this is a token issue tx. 
-                // colorid is hash(coin's scriptpubkey) or prevout
-                case TokenTypes::NONE:
-                    if(outColorId.type == TokenTypes::REISSUABLE)
-                        coinColorId = ColorIdentifier(coin.out.scriptPubKey);
-                    else
-                        coinColorId = ColorIdentifier(txin.prevout, outColorId.type);
-                    break;
+                const Coin& coin = inputs.AccessCoin(txin.prevout);
+                if(coin.IsSpent())
+                    continue;
 
-                // when the coin is REISSUABLE/NON_REISSUABLE/NFT this is a token transfer tx. 
-                // colorid is same as the coin's colorid
-                case TokenTypes::REISSUABLE:
-                case TokenTypes::NON_REISSUABLE:
-                case TokenTypes::NFT:
-                    coinColorId = GetColorIdFromScript(coin.out.scriptPubKey);
-                    break;
+                switch(coin.type)
+                {
+                    // when the coin is TPC this is a token issue tx.
+                    // colorid is hash(coin's scriptpubkey) or prevout
+                    case TokenTypes::NONE:
+                    {
+                        validColorIds.insert(ColorIdentifier(coin.out.scriptPubKey));
+                        ColorIdentifier colorId(txin.prevout, TokenTypes::NON_REISSUABLE);
+                        validColorIds.insert(colorId);
+                        colorId.type = TokenTypes::NFT;
+                        validColorIds.insert(colorId);
+                        break;
+                    }
 
-                default:
-                    continue;
+                    // when the coin is REISSUABLE/NON_REISSUABLE/NFT this is a token transfer tx.
+                    // colorid is same as the coin's colorid
+                    case TokenTypes::REISSUABLE:
+                    case TokenTypes::NON_REISSUABLE:
+                    case TokenTypes::NFT:
+                        validColorIds.insert(GetColorIdFromScript(coin.out.scriptPubKey));
+                        break;
+
+                    default:
+                        break;
+                }
             }
+            fValidColorIdsComputed = true;
+        }
 
-            if(coinColorId == outColorId && !coin.IsSpent())
-            {
-                matchFound = true;
+        if(!validColorIds.count(outColorId))
+            return false;
 
-                //NFT's value is always 1
-                if(outColorId.type == TokenTypes::NFT && txout.nValue != 1)
-                    return false;
+        //NFT's value is always 1
+        if(outColorId.type == TokenTypes::NFT && txout.nValue != 1)
+            return false;
+    }
+    return true;
+}
 
-                //exit inner loop
-                break;
-            }
+/**
+ * A transaction going through AcceptToMemoryPoolBatch: the coins it spends,
+ * fetched under the locks, and the outcome of its script checks, run without
+ * them.
+ */
+struct MempoolAcceptCandidate
+{
+    CTransactionRef ptx;
+    size_t nIndex;
+    CCoinsView dummy;
+    CCoinsViewCache view;
+    PrecomputedTransactionData txdata;
+    std::vector<COutPoint> coins_to_uncache;
+    bool fScriptsChecked;
+    bool fScriptsOk;
+    CValidationState state;
+    TxColoredCoinBalancesMap inColoredCoinBalances;
+
+    MempoolAcceptCandidate(const CTransactionRef& ptxIn, size_t nIndexIn) :
+        ptx(ptxIn), nIndex(nIndexIn), view(&dummy), txdata(*ptxIn), fScriptsChecked(false), fScriptsOk(false) { }
+
+    /** Whether view holds the same coins as the ones the scripts were checked against */
+    bool SpendsSameCoins(const CCoinsViewCache& inputs) const
+    {
+        for (const CTxIn& txin : ptx->vin) {
+            if (!(view.AccessCoin(txin.prevout).out == inputs.AccessCoin(txin.prevout).out))
+                return false;
+        }
+        return true;
+    }
+};
+
+// Check the scripts of a mempool candidate against the standard flags.
+static bool CheckMempoolInputScripts(const CTransaction& tx, CValidationState& state, const CCoinsViewCache& view,
+                 PrecomputedTransactionData& txdata, TxColoredCoinBalancesMap& inColoredCoinBalances)
+{
+    constexpr unsigned int scriptVerifyFlags = STANDARD_SCRIPT_VERIFY_FLAGS;
+
+    if (!CheckInputs(tx, state, view, true, scriptVerifyFlags, true, false, txdata, inColoredCoinBalances)) {
+
+    #ifdef DEBUG
+        TxColoredCoinBalancesMap tmpColoredCoinBalancesTemp;
+        // SCRIPT_VERIFY_CLEANSTACK requires SCRIPT_VERIFY_WITNESS, so we
+        // need to turn both off, and compare against just turning off CLEANSTACK
+        // to see if the failure is specifically due to witness validation.
+        CValidationState stateDummy; // Want reported failures to be from first CheckInputs
+        if (!tx.HasWitness() && CheckInputs(tx, stateDummy, view, true, scriptVerifyFlags & ~(SCRIPT_VERIFY_WITNESS | SCRIPT_VERIFY_CLEANSTACK), true, false, txdata, tmpColoredCoinBalancesTemp) &&
+            !CheckInputs(tx, stateDummy, view, true, scriptVerifyFlags & ~SCRIPT_VERIFY_CLEANSTACK, true, false, txdata, tmpColoredCoinBalancesTemp)) {
+            // Only the witness is missing, so the transaction itself may be fine.
+            state.SetCorruptionPossible();
         }
-        if(!matchFound) return false;
+    #endif
+
+        return false; // state filled in by CheckInputs
     }
     return true;
 }
 
+/**
+ * With pcandidate set, this is a step of AcceptToMemoryPoolBatch. Until the
+ * candidate's scripts are checked, everything up to the script checks is
+ * done, the spent coins are copied to the candidate and the mempool is left
+ * alone. Afterwards the transaction is validated again and added, reusing
+ * the outcome of the script checks if it spends the same coins.
+ */
 static bool AcceptToMemoryPoolWorker(CTxMemPool& pool, CValidationState& state, const CTransactionRef& ptx,
                               bool* pfMissingInputs, int64_t nAcceptTime, std::list<CTransactionRef>* plTxnReplaced,
-                              bool bypass_limits, const CAmount& nAbsurdFee, std::vector<COutPoint>& coins_to_uncache, bool test_accept)
+                              bool bypass_limits, const CAmount& nAbsurdFee, std::vector<COutPoint>& coins_to_uncache, bool test_accept,
+                              MempoolAcceptCandidate* pcandidate = nullptr)
 {
     const CTransaction& tx = *ptx;
     const uint256 hash = tx.GetHashMalFix();
@@ -978,27 +1053,26 @@ static bool AcceptToMemoryPoolWorker(CTxMemPool& pool, CValidationState& state,
             }
         }
 
-        constexpr unsigned int scriptVerifyFlags = STANDARD_SCRIPT_VERIFY_FLAGS;
+        if (pcandidate && !pcandidate->fScriptsChecked) {
+            // Leave the script checks to AcceptToMemoryPoolBatch, which runs
+            // them without the locks against the coins kept here.
+            for (const CTxIn& txin : tx.vin) {
+                pcandidate->view.AddCoin(txin.prevout, Coin(view.AccessCoin(txin.prevout)), true);
+            }
+            return true;
+        }
 
         // Check against previous transactions
         // This is done last to help prevent CPU exhaustion denial-of-service attacks.
         PrecomputedTransactionData txdata(tx);
         TxColoredCoinBalancesMap inColoredCoinBalances;
-        if (!CheckInputs(tx, state, view, true, scriptVerifyFlags, true, false, txdata, inColoredCoinBalances)) {
-
-        #ifdef DEBUG
-            TxColoredCoinBalancesMap tmpColoredCoinBalancesTemp;
-            // SCRIPT_VERIFY_CLEANSTACK requires SCRIPT_VERIFY_WITNESS, so we
-            // need to turn both off, and compare against just turning off CLEANSTACK
-            // to see if the failure is specifically due to witness validation.
-            CValidationState stateDummy; // Want reported failures to be from first CheckInputs
-            if (!tx.HasWitness() && CheckInputs(tx, stateDummy, view, true, scriptVerifyFlags & ~(SCRIPT_VERIFY_WITNESS | SCRIPT_VERIFY_CLEANSTACK), true, false, txdata, tmpColoredCoinBalancesTemp) &&
-                !CheckInputs(tx, stateDummy, view, true, scriptVerifyFlags & ~SCRIPT_VERIFY_CLEANSTACK, true, false, txdata, tmpColoredCoinBalancesTemp)) {
-                // Only the witness is missing, so the transaction itself may be fine.
-                state.SetCorruptionPossible();
+        if (pcandidate && pcandidate->SpendsSameCoins(view)) {
+            if (!pcandidate->fScriptsOk) {
+                state = pcandidate->state;
+                return false;
             }
-        #endif
-
+            inColoredCoinBalances = pcandidate->inColoredCoinBalances;
+        } else if (!CheckMempoolInputScripts(tx, state, view, txdata, inColoredCoinBalances)) {
             return false; // state filled in by CheckInputs
         }
 
@@ -1139,6 +1213,109 @@ bool AcceptToMemoryPool(CTxMemPool& pool, CValidationState &state, const CTransa
     return AcceptToMemoryPoolWithTime(pool, state, tx, pfMissingInputs, GetTime(), plTxnReplaced, bypass_limits, nAbsurdFee, test_accept);
 }
 
+static CCheckQueue<CMempoolInputsCheck> mempoolcheckqueue(1);
+
+void ThreadMempoolScriptCheck() {
+    RenameThread("tapyrus-mempoolcheck");
+    mempoolcheckqueue.Thread();
+}
+
+bool CMempoolInputsCheck::operator()() {
+    pcandidate->fScriptsOk = CheckMempoolInputScripts(*pcandidate->ptx, pcandidate->state, pcandidate->view, pcandidate->txdata, pcandidate->inColoredCoinBalances);
+    pcandidate->fScriptsChecked = true;
+    return true;
+}
+
+void AcceptToMemoryPoolBatch(CTxMemPool& pool, const std::vector<CTransactionRef>& vtx, std::vector<CValidationState>& vState,
+                             std::vector<bool>& vAccepted, std::vector<bool>& vMissingInputs, std::list<CTransactionRef>* plTxnReplaced,
+                             const CAmount nAbsurdFee, CCheckQueue<CMempoolInputsCheck>* pqueue)
+{
+    vState.assign(vtx.size(), CValidationState());
+    vAccepted.assign(vtx.size(), false);
+    vMissingInputs.assign(vtx.size(), false);
+    const int64_t nAcceptTime = GetTime();
+
+    std::vector<size_t> vPending(vtx.size());
+    for (size_t i = 0; i < vtx.size(); i++) {
+        vPending[i] = i;
+    }
+
+    // Each round takes in the transactions whose inputs are known; the ones
+    // missing inputs are tried again if the round accepted something.
+    while (!vPending.empty()) {
+        std::vector<std::unique_ptr<MempoolAcceptCandidate>> vCandidates;
+        std::vector<size_t> vMissing;
+        {
+            LOCK2(cs_main, pool.cs);
+            for (size_t i : vPending) {
+                std::unique_ptr<MempoolAcceptCandidate> candidate = MakeUnique<MempoolAcceptCandidate>(vtx[i], i);
+                bool fMissingInputs = false;
+                vState[i] = CValidationState();
+                const bool fPassed = AcceptToMemoryPoolWorker(pool, vState[i], vtx[i], &fMissingInputs, nAcceptTime, plTxnReplaced,
+                        false, nAbsurdFee, candidate->coins_to_uncache, false, candidate.get());
+                vMissingInputs[i] = fMissingInputs;
+                if (fPassed) {
+                    vCandidates.push_back(std::move(candidate));
+                    continue;
+                }
+                for (const COutPoint& outpoint : candidate->coins_to_uncache)
+                    pcoinsTip->Uncache(outpoint);
+                if (fMissingInputs)
+                    vMissing.push_back(i);
+            }
+        }
+
+        {
+            CCheckQueueControl<CMempoolInputsCheck> control(pqueue);
+            std::vector<CMempoolInputsCheck> vChecks;
+            for (const std::unique_ptr<MempoolAcceptCandidate>& candidate : vCandidates) {
+                CMempoolInputsCheck check(candidate.get());
+                if (pqueue) {
+                    vChecks.push_back(CMempoolInputsCheck());
+                    check.swap(vChecks.back());
+                } else {
+                    check();
+                }
+            }
+            control.Add(vChecks);
+            control.Wait();
+        }
+
+        bool fAcceptedAny = false;
+        {
+            LOCK(cs_main);
+            for (const std::unique_ptr<MempoolAcceptCandidate>& candidate : vCandidates) {
+                const size_t i = candidate->nIndex;
+                bool fMissingInputs = false;
+                if (AcceptToMemoryPoolWorker(pool, vState[i], vtx[i], &fMissingInputs, nAcceptTime, plTxnReplaced,
+                        false, nAbsurdFee, candidate->coins_to_uncache, false, candidate.get())) {
+                    vAccepted[i] = true;
+                    fAcceptedAny = true;
+                    continue;
+                }
+                for (const COutPoint& outpoint : candidate->coins_to_uncache)
+                    pcoinsTip->Uncache(outpoint);
+                vMissingInputs[i] = fMissingInputs;
+            }
+        }
+
+        if (!fAcceptedAny)
+            break;
+        vPending.swap(vMissing);
+    }
+
+    // After we've (potentially) uncached entries, ensure our coins cache is still within its size limits
+    CValidationState stateDummy;
+    FlushStateToDisk(stateDummy, FlushStateMode::PERIODIC);
+}
+
+void AcceptToMemoryPoolBatch(CTxMemPool& pool, const std::vector<CTransactionRef>& vtx, std::vector<CValidationState>& vState,
+                             std::vector<bool>& vAccepted, std::vector<bool>& vMissingInputs, std::list<CTransactionRef>* plTxnReplaced,
+                             const CAmount nAbsurdFee)
+{
+    AcceptToMemoryPoolBatch(pool, vtx, vState, vAccepted, vMissingInputs, plTxnReplaced, nAbsurdFee, nScriptCheckThreads ? &mempoolcheckqueue : nullptr);
+}
+
 /**
  * Return transaction in txOut, and if it was found inside a block, its hash is placed in hashBlock.
  * If blockIndex is provided, the transaction is fetched from the corresponding block.
@@ -1483,6 +1660,36 @@ bool CScriptCheck::operator()() {
     return VerifyScript(scriptSig, m_tx_out.scriptPubKey, witness, nFlags, CachingTransactionSignatureChecker(ptxTo, nIn, m_tx_out.nValue, cacheStore, *txdata), colorid, &error);
 }
 
+bool CScriptCheck::VerifyDeferred(CSchnorrBatchVerifier& batch, std::vector<uint256>& vCacheEntries) {
+    const CScript &scriptSig = ptxTo->vin[nIn].scriptSig;
+    const CScriptWitness *witness = &ptxTo->vin[nIn].scriptWitness;
+    return VerifyScript(scriptSig, m_tx_out.scriptPubKey, witness, nFlags, DeferringTransactionSignatureChecker(ptxTo, nIn, m_tx_out.nValue, cacheStore, *txdata, batch, vCacheEntries), colorid, &error);
+}
+
+bool CScriptBatchCheck::operator()() {
+    CSchnorrBatchVerifier batch;
+    std::vector<uint256> vCacheEntries;
+    bool fDeferredOk = true;
+    for (CScriptCheck& check : vChecks) {
+        if (!check.VerifyDeferred(batch, vCacheEntries)) {
+            fDeferredOk = false;
+            break;
+        }
+    }
+    if (fDeferredOk && (batch.size() == 0 || batch.Verify())) {
+        StoreDeferredSignatureCacheEntries(vCacheEntries);
+        return true;
+    }
+
+    // Some signature assumed valid above was not, or a script failed: the
+    // individual checks decide, and locate the failing input.
+    for (CScriptCheck& check : vChecks) {
+        if (!check())
+            return false;
+    }
+    return true;
+}
+
 int GetSpendHeight(const CCoinsViewCache& inputs)
 {
     LOCK(cs_main);
@@ -1491,12 +1698,106 @@ int GetSpendHeight(const CCoinsViewCache& inputs)
 }
 
 
-static CuckooCache::cache<uint256, SignatureCacheHasher> scriptExecutionCache;
+namespace {
+/**
+ * Valid block proof cache, so that the proof of a signed header is verified
+ * once when the header is accepted and not again when the full block, or a
+ * block built on it, goes through CheckBlockHeader.
+ */
+class CBlockProofCache
+{
+private:
+     //! Entries are SHA256(nonce || hash for sign || aggregate public key || proof):
+    uint256 nonce;
+    typedef CuckooCache::cache<uint256, SignatureCacheHasher> map_type;
+    map_type setValid;
+    boost::shared_mutex cs_blockproofcache;
+    std::atomic<uint64_t> nHits;
+    std::atomic<uint64_t> nMisses;
+    std::atomic<size_t> nElems;
+
+public:
+    CBlockProofCache() : nHits(0), nMisses(0), nElems(0)
+    {
+        GetRandBytes(nonce.begin(), 32);
+    }
+
+    void
+    ComputeEntry(uint256& entry, const uint256 &hash, const std::vector<unsigned char>& vchProof, const CPubKey& pubkey)
+    {
+        CSHA256().Write(nonce.begin(), 32).Write(hash.begin(), 32).Write(pubkey.begin(), pubkey.size()).Write(vchProof.data(), vchProof.size()).Finalize(entry.begin());
+    }
+
+    bool
+    Get(const uint256& entry)
+    {
+        bool fFound;
+        {
+            boost::shared_lock<boost::shared_mutex> lock(cs_blockproofcache);
+            fFound = setValid.contains(entry, false);
+        }
+        ++(fFound ? nHits : nMisses);
+        return fFound;
+    }
+
+    void Set(uint256& entry)
+    {
+        boost::unique_lock<boost::shared_mutex> lock(cs_blockproofcache);
+        setValid.insert(entry);
+    }
+
+    uint32_t setup_bytes(size_t n)
+    {
+        boost::unique_lock<boost::shared_mutex> lock(cs_blockproofcache);
+        nElems = setValid.setup_bytes(n);
+        return nElems;
+    }
+
+    BlockProofCacheStats stats() const
+    {
+        BlockProofCacheStats stats;
+        stats.nHits = nHits;
+        stats.nMisses = nMisses;
+        stats.nElems = nElems;
+        return stats;
+    }
+};
+
+static CBlockProofCache blockProofCache;
+} // namespace
+
+void InitBlockProofCache()
+{
+    size_t nMaxCacheSize = std::min(std::max((int64_t)0, gArgs.GetArg("-maxblockproofcachesize", DEFAULT_MAX_BLOCK_PROOF_CACHE_SIZE)), MAX_MAX_SIG_CACHE_SIZE) * ((size_t) 1 << 20);
+    size_t nElems = blockProofCache.setup_bytes(nMaxCacheSize);
+    LogPrintf("Using %zu MiB out of %zu requested for block proof cache, able to store %zu elements\n",
+            (nElems*sizeof(uint256)) >>20, nMaxCacheSize>>20, nElems);
+}
+
+BlockProofCacheStats GetBlockProofCacheStats()
+{
+    return blockProofCache.stats();
+}
+
+/** Verify a block proof, consulting and filling the block proof cache */
+static bool VerifyBlockProof(const uint256& hash, const CPubKey& aggregatePubkey, const std::vector<unsigned char>& vchProof)
+{
+    uint256 entry;
+    blockProofCache.ComputeEntry(entry, hash, vchProof, aggregatePubkey);
+    if (blockProofCache.Get(entry))
+        return true;
+    if (!aggregatePubkey.Verify_Schnorr(hash, vchProof))
+        return false;
+    blockProofCache.Set(entry);
+    return true;
+}
+
+static CuckooCache::sharded_cache<uint256, SignatureCacheHasher> scriptExecutionCache;
 static uint256 scriptExecutionCacheNonce(GetRandHash());
 
 void InitScriptExecutionCache() {
     // nMaxCacheSize is unsigned. If -maxsigcachesize is set to zero,
-    // setup_bytes creates the minimum possible cache (2 elements).
+    // setup_bytes creates the minimum possible cache (2 elements per shard).
     size_t nMaxCacheSize = std::min(std::max((int64_t)0, gArgs.GetArg("-maxsigcachesize", DEFAULT_MAX_SIG_CACHE_SIZE) / 2), MAX_MAX_SIG_CACHE_SIZE) * ((size_t) 1 << 20);
     size_t nElems = scriptExecutionCache.setup_bytes(nMaxCacheSize);
     LogPrintf("Using %zu MiB out of %zu/2 requested for script execution cache, able to store %zu elements\n",
@@ -1544,7 +1845,6 @@ bool CheckInputs(const CTransaction& tx, CValidationState &state, const CCoinsVi
             // round - giving us 19 + 32 + 4 = 55 bytes (+ 8 + 1 = 64)
             static_assert(55 - sizeof(flags) - 32 >= 128/8, "Want at least 128 bits of nonce for script execution cache");
             CSHA256().Write(scriptExecutionCacheNonce.begin(), 55 - sizeof(flags) - 32).Write(tx.GetWitnessHash().begin(), 32).Write((unsigned char*)&flags, sizeof(flags)).Finalize(hashCacheEntry.begin());
-            AssertLockHeld(cs_main); //TODO: Remove this requirement by making CuckooCache not require external locks
             if (scriptExecutionCache.contains(hashCacheEntry, !cacheFullScriptStore)) {
                 return true;
             }
@@ -1828,7 +2128,7 @@ static bool WriteUndoDataForBlock(const CBlockUndo& blockundo, CValidationState&
     return true;
 }
 
-static CCheckQueue<CScriptCheck> scriptcheckqueue(128);
+static CCheckQueue<CScriptBatchCheck> scriptcheckqueue(1);
 
 void ThreadScriptCheck() {
     RenameThread("tapyrus-scriptch");
@@ -1940,7 +2240,12 @@ bool CChainState::ConnectBlock(const CBlock& block, CValidationState& state, CBl
 
     CBlockUndo blockundo;
 
-    CCheckQueueControl<CScriptCheck> control(fScriptChecks && nScriptCheckThreads ? &scriptcheckqueue : nullptr);
+    CCheckQueueControl<CScriptBatchCheck> control(fScriptChecks && nScriptCheckThreads ? &scriptcheckqueue : nullptr);
+    // Script checks are handed to the queue in groups of BLOCK_SCRIPT_BATCH_SIZE
+    // inputs, each of which batch verifies its Schnorr signatures.
+    std::vector<CScriptCheck> vScriptChecks;
+    vScriptChecks.reserve(BLOCK_SCRIPT_BATCH_SIZE);
+    std::vector<CScriptBatchCheck> vBatchChecks(1);
 
     std::vector<int> prevheights;
     CAmount nFees = 0;
@@ -1994,12 +2299,15 @@ bool CChainState::ConnectBlock(const CBlock& block, CValidationState& state, CBl
         txdata.emplace_back(tx);
         if (!tx.IsCoinBase())
         {
-            std::vector<CScriptCheck> vChecks;
             bool fCacheResults = fJustCheck; /* Don't cache results if we're actually connecting blocks (still consult the cache, though) */
-            if (!CheckInputs(tx, state, view, fScriptChecks, flags, fCacheResults, fCacheResults, txdata[i], inColoredCoinBalances, nScriptCheckThreads ? &vChecks : nullptr))
+            if (!CheckInputs(tx, state, view, fScriptChecks, flags, fCacheResults, fCacheResults, txdata[i], inColoredCoinBalances, nScriptCheckThreads ? &vScriptChecks : nullptr))
                 return error("ConnectBlock(): CheckInputs on %s failed with %s",
                     tx.GetHashMalFix().ToString(), FormatStateMessage(state));
-            control.Add(vChecks);
+            if (vScriptChecks.size() >= BLOCK_SCRIPT_BATCH_SIZE) {
+                CScriptBatchCheck(vScriptChecks).swap(vBatchChecks[0]);
+                control.Add(vBatchChecks);
+                vScriptChecks.reserve(BLOCK_SCRIPT_BATCH_SIZE);
+            }
         }
 
         CTxUndo undoDummy;
@@ -2018,6 +2326,10 @@ bool CChainState::ConnectBlock(const CBlock& block, CValidationState& state, CBl
                                block.vtx[0]->GetValueOut(), blockReward),
                                REJECT_INVALID, "bad-cb-amount");
 
+    if (!vScriptChecks.empty()) {
+        CScriptBatchCheck(vScriptChecks).swap(vBatchChecks[0]);
+        control.Add(vBatchChecks);
+    }
     if (!control.Wait())
         return state.DoS(100, error("%s: CheckQueue failed", __func__), REJECT_INVALID, "block-validation-failed");
     int64_t nTime4 = GetTimeMicros(); nTimeVerify += nTime4 - nTime2;
@@ -2093,11 +2405,13 @@ bool static FlushStateToDisk(CValidationState &state, FlushStateMode mode, int n
         }
         int64_t nMempoolSizeMax = gArgs.GetArg("-maxmempool", DEFAULT_MAX_MEMPOOL_SIZE) * 1000000;
         int64_t cacheSize = pcoinsTip->DynamicMemoryUsage();
+        // Coins still being written in the background count towards the limit too.
+        int64_t flushingSize = pcoinsflushbuffer ? pcoinsflushbuffer->DynamicMemoryUsage() : 0;
         int64_t nTotalSpace = nCoinCacheUsage + std::max<int64_t>(nMempoolSizeMax - nMempoolUsage, 0);
         // The cache is large and we're within 10% and 10 MiB of the limit, but we have time now (not in the middle of a block processing).
         bool fCacheLarge = mode == FlushStateMode::PERIODIC && cacheSize > std::max((9 * nTotalSpace) / 10, nTotalSpace - MAX_BLOCK_COINSDB_USAGE * 1024 * 1024);
         // The cache is over the limit, we have to write now.
-        bool fCacheCritical = mode == FlushStateMode::IF_NEEDED && cacheSize > nTotalSpace;
+        bool fCacheCritical = mode == FlushStateMode::IF_NEEDED && cacheSize + flushingSize > nTotalSpace;
         // It's been a while since we wrote the block index to disk. Do this frequently, so we don't need to redownload after a crash.
         bool fPeriodicWrite = mode == FlushStateMode::PERIODIC && nNow > nLastWrite + (int64_t)DATABASE_WRITE_INTERVAL * 1000000;
         // It's been very long since we flushed the cache. Do this infrequently, to optimize cache usage.
@@ -2129,9 +2443,13 @@ bool static FlushStateToDisk(CValidationState &state, FlushStateMode mode, int n
                     return AbortNode(state, "Failed to write to block index database");
                 }
             }
-            // Finally remove any pruned files
-            if (fFlushForPrune)
+            // Finally remove any pruned files, once a chainstate still being
+            // written in the background no longer needs them to be replayed.
+            if (fFlushForPrune) {
+                if (pcoinsflushbuffer && !pcoinsflushbuffer->Sync())
+                    return AbortNode(state, "Failed to write to coin database");
                 UnlinkPrunedFiles(setFilesToPrune);
+            }
             nLastWrite = nNow;
         }
         // Flush best chain related state. This can only be done if the blocks / block index write was also done.
@@ -2144,8 +2462,13 @@ bool static FlushStateToDisk(CValidationState &state, FlushStateMode mode, int n
             if (!CheckDiskSpace(48 * 2 * 2 * pcoinsTip->GetCacheSize()))
                 return state.Error("out of disk space");
             // Flush the chainstate (which may refer to block index entries).
+            // Periodic flushes are written to the database in the background
+            // while validation goes on; the others wait until it is done.
             if (!pcoinsTip->Flush())
                 return AbortNode(state, "Failed to write to coin database");
+            bool fBackground = mode == FlushStateMode::PERIODIC && !fFlushForPrune;
+            if (!fBackground && pcoinsflushbuffer && !pcoinsflushbuffer->Sync())
+                return AbortNode(state, "Failed to write to coin database");
             nLastFlush = nNow;
             full_flush_completed = true;
         }
@@ -2239,6 +2562,10 @@ bool CChainState::DisconnectTip(CValidationState& state, DisconnectedBlockTransa
             return error("DisconnectTip(): DisconnectBlock %s failed", pindexDelete->GetBlockHash().ToString());
         bool flushed = view.Flush();
         assert(flushed);
+
+        // if it is a federation block, the aggregatepubkey it introduced is no longer in effect
+        if(block.xfieldType == 1)
+            FederationParams().RemoveAggregatePubkeysFromHeight(pindexDelete->nHeight + 1);
     }
     LogPrint(BCLog::BENCH, "- Disconnect block: %.2fms\n", (GetTimeMicros() - nStart) * MILLI);
     // Write the chain state to disk, if necessary.
@@ -2267,7 +2594,76 @@ bool CChainState::DisconnectTip(CValidationState& state, DisconnectedBlockTransa
     return true;
 }
 
+static CCheckQueue<CCoinsPrefetchCheck> coinsprefetchqueue(1);
+
+void ThreadCoinsPrefetch() {
+    RenameThread("tapyrus-prefetch");
+    coinsprefetchqueue.Thread();
+}
+
+bool CCoinsPrefetchCheck::operator()() {
+    for (size_t i = nBegin; i < nEnd; i++) {
+        Coin& coin = (*pvCoins)[i];
+        try {
+            if (!pbase->GetCoin((*pvOutPoints)[i], coin))
+                coin.Clear();
+        } catch (const std::exception&) {
+            // Leave it to ConnectBlock, which reads it again and handles
+            // the error.
+            coin.Clear();
+        }
+    }
+    return true;
+}
+
+size_t PrefetchBlockInputs(const CBlock& block, CCoinsViewCache& cache, CCheckQueue<CCoinsPrefetchCheck>* pqueue)
+{
+    if (!pqueue || block.vtx.size() <= 1)
+        return 0;
+
+    // Outputs created by the block itself are not in the backing view yet.
+    std::unordered_set<uint256, SaltedTxidHasher> setBlockTxids;
+    for (const CTransactionRef& tx : block.vtx) {
+        setBlockTxids.insert(tx->GetHashMalFix());
+    }
+    std::vector<COutPoint> vOutPoints;
+    for (const CTransactionRef& tx : block.vtx) {
+        if (tx->IsCoinBase())
+            continue;
+        for (const CTxIn& txin : tx->vin) {
+            if (!setBlockTxids.count(txin.prevout.hashMalFix) && !cache.HaveCoinInCache(txin.prevout))
+                vOutPoints.push_back(txin.prevout);
+        }
+    }
+    if (vOutPoints.empty())
+        return 0;
+
+    std::vector<Coin> vCoins(vOutPoints.size());
+    {
+        CCheckQueueControl<CCoinsPrefetchCheck> control(pqueue);
+        std::vector<CCoinsPrefetchCheck> vChecks;
+        vChecks.reserve((vOutPoints.size() + COINS_PREFETCH_BATCH_SIZE - 1) / COINS_PREFETCH_BATCH_SIZE);
+        for (size_t begin = 0; begin < vOutPoints.size(); begin += COINS_PREFETCH_BATCH_SIZE) {
+            CCoinsPrefetchCheck check(&cache.GetBackend(), &vOutPoints, &vCoins, begin, std::min(vOutPoints.size(), begin + COINS_PREFETCH_BATCH_SIZE));
+            vChecks.emplace_back();
+            check.swap(vChecks.back());
+        }
+        control.Add(vChecks);
+        control.Wait();
+    }
+
+    // The workers only read the backing view and this thread holds cs_main,
+    // so neither cache nor its backing view changed while they ran.
+    size_t nAdded = 0;
+    for (size_t i = 0; i < vOutPoints.size(); i++) {
+        if (cache.CacheCoin(vOutPoints[i], std::move(vCoins[i])))
+            nAdded++;
+    }
+    return nAdded;
+}
+
 static int64_t nTimeReadFromDisk = 0;
+static int64_t nTimePrefetch = 0;
 static int64_t nTimeConnectTotal = 0;
 static int64_t nTimeFlush = 0;
 static int64_t nTimeChainState = 0;
@@ -2359,10 +2755,15 @@ bool CChainState::ConnectTip(CValidationState& state, CBlockIndex* pindexNew, co
         pthisBlock = pblock;
     }
     const CBlock& blockConnecting = *pthisBlock;
-    // Apply the block atomically to the chain state.
     int64_t nTime2 = GetTimeMicros(); nTimeReadFromDisk += nTime2 - nTime1;
-    int64_t nTime3;
     LogPrint(BCLog::BENCH, "  - Load block from disk: %.2fms [%.2fs]\n", (nTime2 - nTime1) * MILLI, nTimeReadFromDisk * MICRO);
+    // Warm the coins cache with the inputs of the block on several threads.
+    size_t nPrefetched = PrefetchBlockInputs(blockConnecting, *pcoinsTip, nScriptCheckThreads ? &coinsprefetchqueue : nullptr);
+    int64_t nTime2a = GetTimeMicros(); nTimePrefetch += nTime2a - nTime2;
+    LogPrint(BCLog::BENCH, "  - Prefetch %u inputs: %.2fms [%.2fs]\n", (unsigned)nPrefetched, (nTime2a - nTime2) * MILLI, nTimePrefetch * MICRO);
+    nTime2 = nTime2a;
+    int64_t nTime3;
+    // Apply the block atomically to the chain state.
     {
         CCoinsViewCache view(pcoinsTip.get());
         bool rv = ConnectBlock(blockConnecting, state, pindexNew, view);
@@ -2845,7 +3246,7 @@ CBlockIndex* CChainState::AddToBlockIndex(const CBlockHeader& block)
         return it->second;
 
     // Construct new block index object
-    CBlockIndex* pindexNew = new CBlockIndex(block);
+    CBlockIndex* pindexNew = m_block_index_arena.Create(block);
     // We assign the sequence id to blocks only when the full data is available,
     // to avoid miners withholding blocks but broadcasting headers, to get a
     // competitive advantage.
@@ -3024,12 +3425,60 @@ static bool CheckBlockHeader(const CBlockHeader& block, CValidationState& state,
     const uint256 blockHash = block.GetHashForSign();
 
     //verify signature
-    if(!aggregatePubkey.Verify_Schnorr(blockHash, block.proof))
+    if(!VerifyBlockProof(blockHash, aggregatePubkey, block.proof))
         return state.Invalid(false, REJECT_INVALID, "bad-proof", "Proof verification failed");
 
     return true;
 }
 
+static CCheckQueue<CBlockMerkleCheck> blockmerklecheckqueue(1);
+
+void ThreadBlockMerkleCheck() {
+    RenameThread("tapyrus-mrklcheck");
+    blockmerklecheckqueue.Thread();
+}
+
+bool CBlockMerkleCheck::operator()() {
+    bool mutated = false;
+    BlockDualMerkleSubtree(*pblock, nBegin, nEnd, BLOCK_MERKLE_SUBTREE_DEPTH, *pnode, *pimNode, &mutated);
+    *pfMutated = mutated;
+    return true;
+}
+
+void ComputeBlockMerkleRoots(const CBlock& block, uint256& root, uint256& imRoot, bool* mutated, CCheckQueue<CBlockMerkleCheck>* pqueue)
+{
+    const size_t nSubtreeSize = (size_t)1 << BLOCK_MERKLE_SUBTREE_DEPTH;
+    if (!pqueue || block.vtx.size() <= nSubtreeSize) {
+        BlockDualMerkleRoot(block, root, imRoot, mutated);
+        return;
+    }
+
+    // Every subtree but the last is complete, so hashing them separately and
+    // then hashing their roots gives the same result as the whole tree.
+    const size_t nSubtrees = (block.vtx.size() + nSubtreeSize - 1) / nSubtreeSize;
+    std::vector<uint256> vNodes(nSubtrees);
+    std::vector<uint256> vImNodes(nSubtrees);
+    std::vector<unsigned char> vMutated(nSubtrees, 0);
+    {
+        CCheckQueueControl<CBlockMerkleCheck> control(pqueue);
+        std::vector<CBlockMerkleCheck> vChecks(nSubtrees);
+        for (size_t i = 0; i < nSubtrees; i++) {
+            const size_t begin = i * nSubtreeSize;
+            CBlockMerkleCheck check(&block, begin, std::min(block.vtx.size(), begin + nSubtreeSize), &vNodes[i], &vImNodes[i], &vMutated[i]);
+            check.swap(vChecks[i]);
+        }
+        control.Add(vChecks);
+        control.Wait();
+    }
+
+    bool mutation = false, imMutation = false;
+    root = ComputeMerkleRoot(std::move(vNodes), mutated ? &mutation : nullptr);
+    imRoot = ComputeMerkleRoot(std::move(vImNodes), mutated ? &imMutation : nullptr);
+    if (mutated) {
+        *mutated = mutation || imMutation || std::find(vMutated.begin(), vMutated.end(), 1) != vMutated.end();
+    }
+}
+
 bool CheckBlock(const CBlock& block, CValidationState& state, bool fCheckPOW, bool fCheckMerkleRoot)
 {
     // These are checks that are independent of context.
@@ -3040,12 +3489,11 @@ bool CheckBlock(const CBlock& block, CValidationState& state, bool fCheckPOW, bo
     // Check the merkle root.
     if (fCheckMerkleRoot) {
         bool mutated;
-        uint256 hashMerkleRoot2 = BlockMerkleRoot(block, &mutated);
+        uint256 hashMerkleRoot2, hashImMerkleRoot2;
+        ComputeBlockMerkleRoots(block, hashMerkleRoot2, hashImMerkleRoot2, &mutated, nScriptCheckThreads ? &blockmerklecheckqueue : nullptr);
         if (block.hashMerkleRoot != hashMerkleRoot2)
             return state.DoS(100, false, REJECT_INVALID, "bad-txnmrklroot", true, "hashMerkleRoot mismatch");
 
-        uint256 hashImMerkleRoot2 = BlockMerkleRoot(block, &mutated, true);
-
         if (block.hashImMerkleRoot != hashImMerkleRoot2)
             return state.DoS(100, false, REJECT_INVALID, "bad-txnimmrklroot", true, "hashImMerkleRoot mismatch");
 
@@ -3219,7 +3667,7 @@ static bool ContextualCheckBlock(const CBlock& block, CValidationState& state, c
     return true;
 }
 
-bool CChainState::AcceptBlockHeader(const CBlockHeader& block, CValidationState& state, CBlockIndex** ppindex)
+bool CChainState::AcceptBlockHeader(const CBlockHeader& block, CValidationState& state, CBlockIndex** ppindex, bool fCheckProof)
 {
     AssertLockHeld(cs_main);
     // Check for duplicate
@@ -3237,7 +3685,7 @@ bool CChainState::AcceptBlockHeader(const CBlockHeader& block, CValidationState&
             return true;
         }
 
-        if (!CheckBlockHeader(block, state))
+        if (!CheckBlockHeader(block, state, -1, fCheckProof))
             return error("%s: Consensus::CheckBlockHeader: %s, %s", __func__, hash.ToString(), FormatStateMessage(state));
 
         // Get prev block index
@@ -3280,15 +3728,89 @@ bool CChainState::AcceptBlockHeader(const CBlockHeader& block, CValidationState&
     return true;
 }
 
+static CCheckQueue<CBlockHeaderCheck> blockheadercheckqueue(1);
+
+void ThreadBlockHeaderCheck() {
+    RenameThread("tapyrus-hdrcheck");
+    blockheadercheckqueue.Thread();
+}
+
+bool CBlockHeaderCheck::operator()() {
+    CSchnorrBatchVerifier batch;
+    std::vector<size_t> vIndex;
+    std::vector<uint256> vHash;
+    std::vector<uint256> vEntry;
+    vIndex.reserve(nCount);
+    vHash.reserve(nCount);
+    vEntry.reserve(nCount);
+    for (size_t i = 0; i < nCount; i++) {
+        const uint256 hash = pheaders[i].GetHashForSign();
+        uint256 entry;
+        blockProofCache.ComputeEntry(entry, hash, pheaders[i].proof, aggregatePubkey);
+        if (blockProofCache.Get(entry)) {
+            pfValid[i] = 1;
+            continue;
+        }
+        if (batch.Add(aggregatePubkey, hash, pheaders[i].proof)) {
+            vIndex.push_back(i);
+            vHash.push_back(hash);
+            vEntry.push_back(entry);
+        }
+    }
+    if (vIndex.empty())
+        return true;
+    const bool fBatchOk = batch.Verify();
+    for (size_t k = 0; k < vIndex.size(); k++) {
+        // At least one proof is bad if the batch failed. Find out which of
+        // the others can still skip the check under cs_main.
+        if (fBatchOk || aggregatePubkey.Verify_Schnorr(vHash[k], pheaders[vIndex[k]].proof)) {
+            pfValid[vIndex[k]] = 1;
+            blockProofCache.Set(vEntry[k]);
+        }
+    }
+    return true;
+}
+
+void CheckBlockHeaders(const std::vector<CBlockHeader>& headers, const CPubKey& aggregatePubkey, std::vector<unsigned char>& vValid, CCheckQueue<CBlockHeaderCheck>* pqueue)
+{
+    vValid.assign(headers.size(), 0);
+    if (headers.empty() || !aggregatePubkey.IsValid())
+        return;
+
+    CCheckQueueControl<CBlockHeaderCheck> control(pqueue);
+    std::vector<CBlockHeaderCheck> vChecks;
+    for (size_t begin = 0; begin < headers.size(); begin += BLOCK_PROOF_BATCH_SIZE) {
+        const size_t count = std::min(headers.size() - begin, BLOCK_PROOF_BATCH_SIZE);
+        CBlockHeaderCheck check(&headers[begin], count, aggregatePubkey, &vValid[begin]);
+        if (pqueue) {
+            vChecks.push_back(CBlockHeaderCheck());
+            check.swap(vChecks.back());
+        } else {
+            check();
+        }
+    }
+    control.Add(vChecks);
+    control.Wait();
+}
+
 // Exposed wrapper for AcceptBlockHeader
 bool ProcessNewBlockHeaders(const std::vector<CBlockHeader>& headers, CValidationState& state, const CBlockIndex** ppindex, CBlockHeader *first_invalid)
 {
     if (first_invalid != nullptr) first_invalid->SetNull();
+
+    // Check the block proofs on the header check threads before taking
+    // cs_main. This uses the same key CheckBlockHeader would use; should it
+    // change in the meantime, every proof is checked again under the lock.
+    const CPubKey aggregatePubkey = FederationParams().GetAggPubkeyFromHeight(-1);
+    std::vector<unsigned char> vProofVerified;
+    CheckBlockHeaders(headers, aggregatePubkey, vProofVerified, nScriptCheckThreads ? &blockheadercheckqueue : nullptr);
     {
         LOCK(cs_main);
-        for (const CBlockHeader& header : headers) {
+        const bool fSameKey = aggregatePubkey == FederationParams().GetAggPubkeyFromHeight(-1);
+        for (size_t i = 0; i < headers.size(); i++) {
+            const CBlockHeader& header = headers[i];
             CBlockIndex *pindex = nullptr; // Use a temp pindex instead of ppindex to avoid a const_cast
-            if (!g_chainstate.AcceptBlockHeader(header, state, &pindex)) {
+            if (!g_chainstate.AcceptBlockHeader(header, state, &pindex, !(fSameKey && vProofVerified[i]))) {
                 if (first_invalid) *first_invalid = header;
                 return false;
             }
@@ -3676,7 +4198,7 @@ CBlockIndex * CChainState::InsertBlockIndex(const uint256& hash)
         return (*mi).second;
 
     // Create new
-    CBlockIndex* pindexNew = new CBlockIndex();
+    CBlockIndex* pindexNew = m_block_index_arena.Create();
     mi = mapBlockIndex.insert(std::make_pair(hash, pindexNew)).first;
     pindexNew->phashBlock = &((*mi).first);
 
@@ -3810,6 +4332,14 @@ bool LoadChainTip()
     }
     chainActive.SetTip(pindex);
 
+    // load the aggregatepubkeys introduced by federation blocks of the active chain into CFederationParams
+    for (int nHeight = 1; nHeight <= chainActive.Height(); nHeight++) {
+        const CBlockIndex* pindexWalk = chainActive[nHeight];
+        const std::vector<unsigned char>& xfield = pindexWalk->GetXField();
+        if(pindexWalk->xfieldType == 1 && xfield.size() == CPubKey::COMPRESSED_PUBLIC_KEY_SIZE && (CPubKey(xfield.begin(), xfield.end()) != FederationParams().GetLatestAggregatePubkey()))
+            FederationParams().ReadAggregatePubkey(xfield, nHeight + 1);
+    }
+
     g_chainstate.PruneBlockIndexCandidates();
 
     LogPrintf("Loaded best chain: hashBestChain=%s height=%d date=%s progress=%f\n",
@@ -4099,6 +4629,7 @@ void CChainState::UnloadBlockIndex() {
     nBlockSequenceId = 1;
     m_failed_blocks.clear();
     setBlockIndexCandidates.clear();
+    m_block_index_arena.Clear();
 }
 
 // May NOT be used after any connections are up as much
@@ -4117,9 +4648,7 @@ void UnloadBlockIndex()
     setDirtyBlockIndex.clear();
     setDirtyFileInfo.clear();
 
-    for (BlockMap::value_type& entry : mapBlockIndex) {
-        delete entry.second;
-    }
+    // the entries themselves are freed by g_chainstate
     mapBlockIndex.clear();
     fHavePruned = false;
 
@@ -4648,19 +5177,6 @@ double GuessVerificationProgress(const ChainTxData& data, const CBlockIndex *pin
     return pindex->nChainTx / fTxTotal;
 }
 
-class CMainCleanup
-{
-public:
-    CMainCleanup() {}
-    ~CMainCleanup() {
-        // block headers
-        BlockMap::iterator it1 = mapBlockIndex.begin();
-        for (; it1 != mapBlockIndex.end(); it1++)
-            delete (*it1).second;
-        mapBlockIndex.clear();
-    }
-} instance_of_cmaincleanup;
-
 bool isBlockHeightInCoinbase(const CBlock& block)
 {
     // tapyrus coinbase must have blockheight in the prevout.n
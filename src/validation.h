@@ -37,9 +37,18 @@ class CBlockIndex;
 class CBlockTreeDB;
 class CChainParams;
 class CCoinsViewDB;
+class CCoinsViewFlushBuffer;
 class CInv;
 class CConnman;
 class CScriptCheck;
+class CScriptBatchCheck;
+class CSchnorrBatchVerifier;
+class CBlockHeaderCheck;
+class CBlockMerkleCheck;
+class CCoinsPrefetchCheck;
+class CMempoolInputsCheck;
+struct MempoolAcceptCandidate;
+template <typename T> class CCheckQueue;
 class CBlockPolicyEstimator;
 class CTxMemPool;
 class CValidationState;
@@ -80,7 +89,7 @@ static const unsigned int BLOCKFILE_CHUNK_SIZE = 0x1000000; // 16 MiB
 static const unsigned int UNDOFILE_CHUNK_SIZE = 0x100000; // 1 MiB
 
 /** Maximum number of script-checking threads allowed */
-static const int MAX_SCRIPTCHECK_THREADS = 16;
+static const int MAX_SCRIPTCHECK_THREADS = 64;
 /** -par default (number of script-checking threads, 0 = auto) */
 static const int DEFAULT_SCRIPTCHECK_THREADS = 0;
 /** Number of blocks that can be requested at any given time from a single peer. */
@@ -90,6 +99,14 @@ static const unsigned int BLOCK_STALLING_TIMEOUT = 2;
 /** Number of headers sent in one getheaders result. We rely on the assumption that if a peer sends
  *  less than this number, we reached its tip. Changing this value is a protocol upgrade. */
 static const unsigned int MAX_HEADERS_RESULTS = 2000;
+/** -maxblockproofcachesize default, in MiB (over 130000 entries) */
+static const int64_t DEFAULT_MAX_BLOCK_PROOF_CACHE_SIZE = 4;
+/** Number of block proofs verified together by one header checking job */
+static const size_t BLOCK_PROOF_BATCH_SIZE = 64;
+/** Depth of the merkle subtrees hashed by one block merkle checking job (512 transactions) */
+static const int BLOCK_MERKLE_SUBTREE_DEPTH = 9;
+/** Number of inputs whose Schnorr signatures are batch verified together by one script checking job */
+static const size_t BLOCK_SCRIPT_BATCH_SIZE = 64;
 /** Maximum depth of blocks we're willing to serve as compact blocks to peers
  *  when requested. For older blocks, a regular BLOCK response will be sent. */
 static const int MAX_CMPCTBLOCK_DEPTH = 5;
@@ -265,6 +282,14 @@ bool LoadChainTip();
 void UnloadBlockIndex();
 /** Run an instance of the script checking thread */
 void ThreadScriptCheck();
+/** Run an instance of the block header proof checking thread */
+void ThreadBlockHeaderCheck();
+/** Run an instance of the block merkle root checking thread */
+void ThreadBlockMerkleCheck();
+/** Run an instance of the mempool script checking thread */
+void ThreadMempoolScriptCheck();
+/** Run an instance of the coins prefetching thread */
+void ThreadCoinsPrefetch();
 /** Check whether we are doing an initial block download (synchronizing from disk or network) */
 bool IsInitialBlockDownload();
 /** Retrieve a transaction (from memory pool, or from disk, if possible) */
@@ -307,6 +332,23 @@ bool AcceptToMemoryPool(CTxMemPool& pool, CValidationState &state, const CTransa
                         bool* pfMissingInputs, std::list<CTransactionRef>* plTxnReplaced,
                         bool bypass_limits, const CAmount nAbsurdFee, bool test_accept=false);
 
+/**
+ * (try to) add a burst of transactions to memory pool. The cheap checks and
+ * the coin lookups of every transaction are done under cs_main and pool.cs,
+ * their scripts are then checked on the threads of pqueue (or inline if
+ * pqueue is nullptr) with the locks released, and the transactions that
+ * passed are re-validated and added under the locks again. Transactions
+ * spending outputs of others accepted in the same call are retried after
+ * them. vState, vAccepted and vMissingInputs are filled in per transaction.
+ */
+void AcceptToMemoryPoolBatch(CTxMemPool& pool, const std::vector<CTransactionRef>& vtx, std::vector<CValidationState>& vState,
+                             std::vector<bool>& vAccepted, std::vector<bool>& vMissingInputs, std::list<CTransactionRef>* plTxnReplaced,
+                             const CAmount nAbsurdFee, CCheckQueue<CMempoolInputsCheck>* pqueue);
+/** As above, checking the scripts on the mempool script checking threads */
+void AcceptToMemoryPoolBatch(CTxMemPool& pool, const std::vector<CTransactionRef>& vtx, std::vector<CValidationState>& vState,
+                             std::vector<bool>& vAccepted, std::vector<bool>& vMissingInputs, std::list<CTransactionRef>* plTxnReplaced,
+                             const CAmount nAbsurdFee);
+
 /** Convert CValidationState to a human-readable message for logging */
 std::string FormatStateMessage(const CValidationState &state);
 
@@ -342,6 +384,12 @@ bool TestLockPointValidity(const LockPoints* lp);
  */
 bool CheckSequenceLocks(const CTransaction &tx, int flags, LockPoints* lp = nullptr, bool useExistingLockPoints = false);
 
+/**
+ * Check that every colored output of tx carries a color id that one of its
+ * unspent inputs can issue or transfer, and that NFT outputs hold exactly 1.
+ */
+bool CheckColorIdentifierValidity(const CTransaction& tx, CValidationState& state, CCoinsViewCache &inputs);
+
 /**
  * Closure representing one script verification
  * Note that this stores references to the spending transaction
@@ -365,6 +413,13 @@ public:
 
     bool operator()();
 
+    /**
+     * Run the script, queueing uncached Schnorr signatures into batch instead
+     * of verifying them (see DeferringTransactionSignatureChecker). A true
+     * result only holds if batch verifies afterwards.
+     */
+    bool VerifyDeferred(CSchnorrBatchVerifier& batch, std::vector<uint256>& vCacheEntries);
+
     void swap(CScriptCheck &check) {
         std::swap(ptxTo, check.ptxTo);
         std::swap(m_tx_out, check.m_tx_out);
@@ -380,9 +435,184 @@ public:
     const ColorIdentifier& GetColorIdentifier() const { return colorid; }
 };
 
+/**
+ * Closure running a group of script verifications whose Schnorr signatures
+ * are verified in one batch. If a script or the batch fails, every check is
+ * run again on its own, so the result is exactly that of the individual checks.
+ */
+class CScriptBatchCheck
+{
+private:
+    std::vector<CScriptCheck> vChecks;
+
+public:
+    CScriptBatchCheck() {}
+
+    /** Take over the checks in vChecksIn, leaving it empty. */
+    explicit CScriptBatchCheck(std::vector<CScriptCheck>& vChecksIn) { vChecks.swap(vChecksIn); }
+
+    bool operator()();
+
+    void swap(CScriptBatchCheck &check) {
+        vChecks.swap(check.vChecks);
+    }
+};
+
+/**
+ * Closure verifying the proofs of a run of block headers against one
+ * aggregate public key. pfValid[i] is set for every header whose proof is
+ * known to be valid; the others are left for CheckBlockHeader to report.
+ * Note that this stores references to the headers and the result array
+ */
+class CBlockHeaderCheck
+{
+private:
+    const CBlockHeader *pheaders;
+    size_t nCount;
+    CPubKey aggregatePubkey;
+    unsigned char *pfValid;
+
+public:
+    CBlockHeaderCheck(): pheaders(nullptr), nCount(0), pfValid(nullptr) {}
+    CBlockHeaderCheck(const CBlockHeader* pheadersIn, size_t nCountIn, const CPubKey& aggregatePubkeyIn, unsigned char* pfValidIn) :
+        pheaders(pheadersIn), nCount(nCountIn), aggregatePubkey(aggregatePubkeyIn), pfValid(pfValidIn) { }
+
+    bool operator()();
+
+    void swap(CBlockHeaderCheck &check) {
+        std::swap(pheaders, check.pheaders);
+        std::swap(nCount, check.nCount);
+        std::swap(aggregatePubkey, check.aggregatePubkey);
+        std::swap(pfValid, check.pfValid);
+    }
+};
+
+/**
+ * Verify the proofs of headers against aggregatePubkey in runs of
+ * BLOCK_PROOF_BATCH_SIZE, spread over the threads of pqueue (or inline if
+ * pqueue is nullptr). vValid[i] is set to 1 for every verified proof.
+ */
+void CheckBlockHeaders(const std::vector<CBlockHeader>& headers, const CPubKey& aggregatePubkey, std::vector<unsigned char>& vValid, CCheckQueue<CBlockHeaderCheck>* pqueue);
+
+/**
+ * Closure hashing one subtree of BLOCK_MERKLE_SUBTREE_DEPTH levels of both
+ * merkle trees of a block.
+ * Note that this stores references to the block and the result slots
+ */
+class CBlockMerkleCheck
+{
+private:
+    const CBlock *pblock;
+    size_t nBegin;
+    size_t nEnd;
+    uint256 *pnode;
+    uint256 *pimNode;
+    unsigned char *pfMutated;
+
+public:
+    CBlockMerkleCheck(): pblock(nullptr), nBegin(0), nEnd(0), pnode(nullptr), pimNode(nullptr), pfMutated(nullptr) {}
+    CBlockMerkleCheck(const CBlock* pblockIn, size_t nBeginIn, size_t nEndIn, uint256* pnodeIn, uint256* pimNodeIn, unsigned char* pfMutatedIn) :
+        pblock(pblockIn), nBegin(nBeginIn), nEnd(nEndIn), pnode(pnodeIn), pimNode(pimNodeIn), pfMutated(pfMutatedIn) { }
+
+    bool operator()();
+
+    void swap(CBlockMerkleCheck &check) {
+        std::swap(pblock, check.pblock);
+        std::swap(nBegin, check.nBegin);
+        std::swap(nEnd, check.nEnd);
+        std::swap(pnode, check.pnode);
+        std::swap(pimNode, check.pimNode);
+        std::swap(pfMutated, check.pfMutated);
+    }
+};
+
+/**
+ * Compute both merkle roots of block as BlockDualMerkleRoot does. Blocks with
+ * more than one subtree of BLOCK_MERKLE_SUBTREE_DEPTH levels are hashed on the
+ * threads of pqueue; if pqueue is nullptr everything runs inline.
+ */
+void ComputeBlockMerkleRoots(const CBlock& block, uint256& root, uint256& imRoot, bool* mutated, CCheckQueue<CBlockMerkleCheck>* pqueue);
+
+/** Number of outpoints read by one CCoinsPrefetchCheck. */
+static const size_t COINS_PREFETCH_BATCH_SIZE = 16;
+
+/**
+ * Closure reading a range of outpoints from the view backing a coins cache.
+ * Note that this stores references to the outpoints and the result slots
+ */
+class CCoinsPrefetchCheck
+{
+private:
+    const CCoinsView *pbase;
+    const std::vector<COutPoint> *pvOutPoints;
+    std::vector<Coin> *pvCoins;
+    size_t nBegin;
+    size_t nEnd;
+
+public:
+    CCoinsPrefetchCheck(): pbase(nullptr), pvOutPoints(nullptr), pvCoins(nullptr), nBegin(0), nEnd(0) {}
+    CCoinsPrefetchCheck(const CCoinsView* pbaseIn, const std::vector<COutPoint>* pvOutPointsIn, std::vector<Coin>* pvCoinsIn, size_t nBeginIn, size_t nEndIn) :
+        pbase(pbaseIn), pvOutPoints(pvOutPointsIn), pvCoins(pvCoinsIn), nBegin(nBeginIn), nEnd(nEndIn) { }
+
+    bool operator()();
+
+    void swap(CCoinsPrefetchCheck &check) {
+        std::swap(pbase, check.pbase);
+        std::swap(pvOutPoints, check.pvOutPoints);
+        std::swap(pvCoins, check.pvCoins);
+        std::swap(nBegin, check.nBegin);
+        std::swap(nEnd, check.nEnd);
+    }
+};
+
+/**
+ * Read the coins spent by block that cache does not hold yet from its backing
+ * view on the threads of pqueue, and add them to cache, so that connecting
+ * the block does not read them from the database one at a time. Returns the
+ * number of coins added. The backing view must be safe to read from several
+ * threads, as the database behind pcoinsTip is; nothing happens if pqueue is
+ * nullptr.
+ */
+size_t PrefetchBlockInputs(const CBlock& block, CCoinsViewCache& cache, CCheckQueue<CCoinsPrefetchCheck>* pqueue);
+
+/**
+ * Closure running the script checks of one transaction taken in by
+ * AcceptToMemoryPoolBatch against the coins fetched for it. It always
+ * succeeds; the outcome is kept in the candidate for the commit step.
+ * Note that this stores a reference to the candidate
+ */
+class CMempoolInputsCheck
+{
+private:
+    MempoolAcceptCandidate *pcandidate;
+
+public:
+    CMempoolInputsCheck(): pcandidate(nullptr) {}
+    explicit CMempoolInputsCheck(MempoolAcceptCandidate* pcandidateIn) : pcandidate(pcandidateIn) { }
+
+    bool operator()();
+
+    void swap(CMempoolInputsCheck &check) {
+        std::swap(pcandidate, check.pcandidate);
+    }
+};
+
 /** Initializes the script-execution cache */
 void InitScriptExecutionCache();
 
+/** Hit and miss counters of the block proof cache */
+struct BlockProofCacheStats
+{
+    uint64_t nHits;
+    uint64_t nMisses;
+    size_t nElems;
+};
+
+/** Initializes the block proof cache */
+void InitBlockProofCache();
+/** Return the block proof cache counters */
+BlockProofCacheStats GetBlockProofCacheStats();
+
 
 /** Functions for disk access for blocks */
 bool ReadBlockFromDisk(CBlock& block, const CDiskBlockPos& pos, int height);
@@ -444,6 +674,9 @@ extern CChain& chainActive;
 /** Global variable that points to the coins database (protected by cs_main) */
 extern std::unique_ptr<CCoinsViewDB> pcoinsdbview;
 
+/** Global variable that points to the layer writing flushed coins to the database in the background, if any (protected by cs_main) */
+extern std::unique_ptr<CCoinsViewFlushBuffer> pcoinsflushbuffer;
+
 /** Global variable that points to the active CCoinsView (protected by cs_main) */
 extern std::unique_ptr<CCoinsViewCache> pcoinsTip;
 
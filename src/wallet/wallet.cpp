@@ -2506,20 +2506,22 @@ bool CWallet::SignTransaction(CMutableTransaction &tx)
     AssertLockHeld(cs_wallet); // mapWallet
 
     // sign the new tx
-    int nIn = 0;
-    for (auto& input : tx.vin) {
+    const PrecomputedTransactionData txdata(tx);
+    std::vector<const CTxOut*> vSpent;
+    for (const auto& input : tx.vin) {
         std::map<uint256, CWalletTx>::const_iterator mi = mapWallet.find(input.prevout.hashMalFix);
         if(mi == mapWallet.end() || input.prevout.n >= mi->second.tx->vout.size()) {
             return false;
         }
-        const CScript& scriptPubKey = mi->second.tx->vout[input.prevout.n].scriptPubKey;
-        const CAmount& amount = mi->second.tx->vout[input.prevout.n].nValue;
-        SignatureData sigdata;
-        if (!ProduceSignature(*this, MutableTransactionSignatureCreator(&tx, nIn, amount, SIGHASH_ALL), scriptPubKey, sigdata)) {
+        vSpent.push_back(&mi->second.tx->vout[input.prevout.n]);
+    }
+    std::vector<SignatureData> vSigData(tx.vin.size());
+    ProduceSignatures(*this, tx, vSpent, SIGHASH_ALL, SignatureScheme::ECDSA, &txdata, vSigData, std::max(nScriptCheckThreads, 1));
+    for (size_t nIn = 0; nIn < tx.vin.size(); nIn++) {
+        if (!vSigData[nIn].complete) {
             return false;
         }
-        UpdateInput(input, sigdata);
-        nIn++;
+        UpdateInput(tx.vin[nIn], vSigData[nIn]);
     }
     return true;
 }
@@ -2944,21 +2946,21 @@ bool CWallet::CreateTransaction(const std::vector<CRecipient>& vecSend, CTransac
 
         if (sign)
         {
-            int nIn = 0;
-            for (const auto& coin : selected_coins)
+            const PrecomputedTransactionData txdata(txNew);
+            std::vector<const CTxOut*> vSpent;
+            for (const auto& coin : selected_coins) {
+                vSpent.push_back(&coin.txout);
+            }
+            std::vector<SignatureData> vSigData(txNew.vin.size());
+            ProduceSignatures(*this, txNew, vSpent, SIGHASH_ALL, SignatureScheme::ECDSA, &txdata, vSigData, std::max(nScriptCheckThreads, 1));
+            for (size_t nIn = 0; nIn < txNew.vin.size(); nIn++)
             {
-                const CScript& scriptPubKey = coin.txout.scriptPubKey;
-                SignatureData sigdata;
-
-                if (!ProduceSignature(*this, MutableTransactionSignatureCreator(&txNew, nIn, coin.txout.nValue, SIGHASH_ALL), scriptPubKey, sigdata))
+                if (!vSigData[nIn].complete)
                 {
                     strFailReason = _("Signing transaction failed");
                     return false;
-                } else {
-                    UpdateInput(txNew.vin.at(nIn), sigdata);
                 }
-
-                nIn++;
+                UpdateInput(txNew.vin.at(nIn), vSigData[nIn]);
             }
         }
 
@@ -278,6 +278,10 @@ public:
 //Get the marginal bytes of spending the specified output
 int CalculateMaximumSignedInputSize(const CTxOut& txout, const CWallet* pwallet, bool use_max_sig = false);
 
+//! Balance cache of a wallet transaction. There are seven of them in every
+//! CWalletTx and they only hold TPC so far, so one entry is kept inline.
+typedef smallmap<1, ColorIdentifier, CAmount, ColorIdentifierCompare> CachedColoredCoinBalancesMap;
+
 /**
  * A transaction with a bunch of additional info that only the owner cares about.
  * It includes any unrecorded transactions needed to link it back to the block chain.
@@ -346,13 +350,13 @@ public:
     mutable bool fAvailableWatchCreditCached;
     mutable bool fChangeCached;
     mutable bool fInMempool;
-    mutable TxColoredCoinBalancesMap nDebitCached;
-    mutable TxColoredCoinBalancesMap nCreditCached;
-    mutable TxColoredCoinBalancesMap nAvailableCreditCached;
-    mutable TxColoredCoinBalancesMap nWatchDebitCached;
-    mutable TxColoredCoinBalancesMap nWatchCreditCached;
-    mutable TxColoredCoinBalancesMap nAvailableWatchCreditCached;
-    mutable TxColoredCoinBalancesMap nChangeCached;
+    mutable CachedColoredCoinBalancesMap nDebitCached;
+    mutable CachedColoredCoinBalancesMap nCreditCached;
+    mutable CachedColoredCoinBalancesMap nAvailableCreditCached;
+    mutable CachedColoredCoinBalancesMap nWatchDebitCached;
+    mutable CachedColoredCoinBalancesMap nWatchCreditCached;
+    mutable CachedColoredCoinBalancesMap nAvailableWatchCreditCached;
+    mutable CachedColoredCoinBalancesMap nChangeCached;
 
     CWalletTx(const CWallet* pwalletIn, CTransactionRef arg) : CMerkleTx(std::move(arg))
     {